@@ -0,0 +1,71 @@
+"""Compare memory and speed of exact and approximate distinct counting.
+
+python benchmarks/approx_count_distinct.py [number of rows] [number of groups]
+"""
+
+import sys
+import tracemalloc
+from time import perf_counter
+
+from convtools import conversion as c
+
+
+ROWS = int(sys.argv[1]) if len(sys.argv) > 1 else 1000000
+GROUPS = int(sys.argv[2]) if len(sys.argv) > 2 else 100
+DATA = [(i % GROUPS, i) for i in range(ROWS)]
+PRECISIONS = (10, 12, 14)
+
+
+def gen_converter(reducer):
+    return (
+        c.group_by(c.item(0))
+        .aggregate((c.item(0), reducer(c.item(1))))
+        .gen_converter()
+    )
+
+
+def measure(converter, repeat=3):
+    times = []
+    for _ in range(repeat):
+        time_start = perf_counter()
+        result = converter(DATA)
+        times.append(perf_counter() - time_start)
+    elapsed = min(times)
+
+    tracemalloc.start()
+    try:
+        converter(DATA)
+        peak = tracemalloc.get_traced_memory()[1]
+    finally:
+        tracemalloc.stop()
+    return elapsed, peak, result
+
+
+def run():
+    print(f"rows: {ROWS}, groups: {GROUPS}")
+    exact_time, exact_peak, exact = measure(
+        gen_converter(c.ReduceFuncs.CountDistinct)
+    )
+    print(f"{'exact':>10}: {exact_time:.3f}s, {exact_peak / 2**20:.1f}MB")
+    for precision in PRECISIONS:
+        time_, peak, result = measure(
+            gen_converter(
+                lambda conv, precision=precision: (
+                    c.ReduceFuncs.ApproxCountDistinct(
+                        conv, precision=precision
+                    )
+                )
+            )
+        )
+        max_error = max(
+            abs(approx - count) / count
+            for (_, count), (_, approx) in zip(exact, result)
+        )
+        print(
+            f"{f'p={precision}':>10}: {time_:.3f}s, {peak / 2**20:.1f}MB, "
+            f"max error: {max_error:.2%}"
+        )
+
+
+if __name__ == "__main__":
+    run()
@@ -0,0 +1,92 @@
+"""Compare memory, speed and accuracy of exact and approximate percentiles.
+
+python benchmarks/approx_percentile.py [number of rows] [number of groups]
+"""
+
+import sys
+import tracemalloc
+from bisect import bisect_left
+from random import random, seed
+from time import perf_counter
+
+from convtools import conversion as c
+
+
+seed(1)
+
+ROWS = int(sys.argv[1]) if len(sys.argv) > 1 else 1000000
+GROUPS = int(sys.argv[2]) if len(sys.argv) > 2 else 10
+DATA = [(i % GROUPS, random()) for i in range(ROWS)]
+PERCENTILES = (1, 25, 50, 75, 99)
+KS = (50, 200, 800)
+
+
+def gen_converter(reducer):
+    return (
+        c.group_by(c.item(0))
+        .aggregate(
+            (
+                c.item(0),
+                c.ReduceFuncs.Array(c.item(1)).pipe(sorted),
+                [reducer(percentile, c.item(1)) for percentile in PERCENTILES],
+            )
+        )
+        .gen_converter()
+    )
+
+
+def measure(converter, repeat=3):
+    times = []
+    for _ in range(repeat):
+        time_start = perf_counter()
+        result = converter(DATA)
+        times.append(perf_counter() - time_start)
+
+    tracemalloc.start()
+    try:
+        converter(DATA)
+        peak = tracemalloc.get_traced_memory()[1]
+    finally:
+        tracemalloc.stop()
+    return min(times), peak, result
+
+
+def max_rank_error(result):
+    # the exact values to compare with are collected by the same converter
+    return max(
+        abs(bisect_left(values, estimate) / (len(values) - 1) - p / 100)
+        for _, values, estimates in result
+        for p, estimate in zip(PERCENTILES, estimates)
+    )
+
+
+def run():
+    print(f"rows: {ROWS}, groups: {GROUPS}")
+    base_time, base_peak, _ = measure(
+        gen_converter(lambda percentile, conv: c.naive(None))
+    )
+    exact_time, exact_peak, result = measure(
+        gen_converter(c.ReduceFuncs.Percentile)
+    )
+    print(
+        f"{'exact':>10}: {exact_time - base_time:.3f}s, "
+        f"{(exact_peak - base_peak) / 2**20:.1f}MB, "
+        f"max rank error: {max_rank_error(result):.2%}"
+    )
+    for k in KS:
+        time_, peak, result = measure(
+            gen_converter(
+                lambda percentile, conv, k=k: (
+                    c.ReduceFuncs.ApproxPercentile(percentile, conv, k=k)
+                )
+            )
+        )
+        print(
+            f"{f'k={k}':>10}: {time_ - base_time:.3f}s, "
+            f"{(peak - base_peak) / 2**20:.1f}MB, "
+            f"max rank error: {max_rank_error(result):.2%}"
+        )
+
+
+if __name__ == "__main__":
+    run()
@@ -0,0 +1,68 @@
+"""Compare memory and speed of exact and approximate top k values.
+
+python benchmarks/approx_top.py [number of rows] [number of distinct values]
+"""
+
+import sys
+import tracemalloc
+from collections import Counter
+from itertools import accumulate
+from random import choices, seed
+from time import perf_counter
+
+from convtools import conversion as c
+
+
+seed(1)
+
+ROWS = int(sys.argv[1]) if len(sys.argv) > 1 else 1000000
+DISTINCT = int(sys.argv[2]) if len(sys.argv) > 2 else 1000000
+K = 10
+CAPACITIES = (100, 1000, 10000)
+
+# zipf distributed urls: a few are frequent, most are rare
+DATA = choices(
+    [f"/page/{i}" for i in range(DISTINCT)],
+    cum_weights=list(accumulate(1 / i**1.1 for i in range(1, DISTINCT + 1))),
+    k=ROWS,
+)
+EXPECTED = [value for value, _ in Counter(DATA).most_common(K)]
+
+
+def measure(converter, repeat=3):
+    times = []
+    for _ in range(repeat):
+        time_start = perf_counter()
+        result = converter(DATA)
+        times.append(perf_counter() - time_start)
+
+    tracemalloc.start()
+    try:
+        converter(DATA)
+        peak = tracemalloc.get_traced_memory()[1]
+    finally:
+        tracemalloc.stop()
+    return min(times), peak, result
+
+
+def run():
+    print(f"rows: {ROWS}, distinct values: {DISTINCT}, k: {K}")
+    time_, peak, _ = measure(
+        c.aggregate(c.ReduceFuncs.TopK(K, c.this)).gen_converter()
+    )
+    print(f"{'exact':>15}: {time_:.3f}s, {peak / 2**20:.1f}MB")
+    for capacity in CAPACITIES:
+        time_, peak, result = measure(
+            c.aggregate(
+                c.ReduceFuncs.ApproxTop(K, c.this, capacity=capacity)
+            ).gen_converter()
+        )
+        print(
+            f"{f'capacity={capacity}':>15}: {time_:.3f}s, "
+            f"{peak / 2**20:.1f}MB, "
+            f"top {K} found: {len(set(result) & set(EXPECTED))}"
+        )
+
+
+if __name__ == "__main__":
+    run()
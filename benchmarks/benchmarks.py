@@ -154,6 +154,109 @@ class IterOfIter1(BaseBenchmark):
         return list(range(10000))
 
 
+class NestedDictLookups1(BaseBenchmark):
+    @staticmethod
+    def gen_conversion():
+        return c.iter(
+            {
+                "id": c.item("payload", "user", "id"),
+                "name": c.item("payload", "user", "name"),
+                "city": c.item("payload", "user", "address", "city"),
+                "zip": c.item("payload", "user", "address", "zip"),
+                "total": c.item("payload", "order", "price")
+                * c.item("payload", "order", "quantity"),
+            },
+            where=c.item("payload", "order", "quantity") > 0,
+        ).as_type(list)
+
+    def gen_converter(self):
+        return self.gen_conversion().gen_converter()
+
+    def gen_naive_implementations(self):
+        def f(data):
+            result = []
+            for row in data:
+                payload = row["payload"]
+                order = payload["order"]
+                if order["quantity"] > 0:
+                    user = payload["user"]
+                    address = user["address"]
+                    result.append(
+                        {
+                            "id": user["id"],
+                            "name": user["name"],
+                            "city": address["city"],
+                            "zip": address["zip"],
+                            "total": order["price"] * order["quantity"],
+                        }
+                    )
+            return result
+
+        yield f
+
+    def gen_data(self):
+        return [
+            {
+                "payload": {
+                    "user": {
+                        "id": i,
+                        "name": choice(ascii_letters),
+                        "address": {"city": "Paris", "zip": str(i)},
+                    },
+                    "order": {"price": random(), "quantity": i % 3},
+                }
+            }
+            for i in range(10000)
+        ]
+
+
+class IterFilterChain1(BaseBenchmark):
+    @staticmethod
+    def gen_conversion():
+        return (
+            c.iter(c.item("order"))
+            .filter(c.item("quantity") > 0)
+            .iter(c.item("price") * c.item("quantity"))
+            .filter(c.this > 0.5)
+            .as_type(list)
+        )
+
+    def gen_converter(self):
+        return self.gen_conversion().gen_converter()
+
+    def gen_naive_implementations(self):
+        def f(data):
+            return [
+                total
+                for total in (
+                    order["price"] * order["quantity"]
+                    for order in (row["order"] for row in data)
+                    if order["quantity"] > 0
+                )
+                if total > 0.5
+            ]
+
+        yield f
+
+        def f(data):
+            result = []
+            for row in data:
+                order = row["order"]
+                if order["quantity"] > 0:
+                    total = order["price"] * order["quantity"]
+                    if total > 0.5:
+                        result.append(total)
+            return result
+
+        yield f
+
+    def gen_data(self):
+        return [
+            {"order": {"price": random(), "quantity": i % 3}}
+            for i in range(10000)
+        ]
+
+
 class TableDictReader(BaseBenchmark):
     def gen_converter(self):
         def f(data):
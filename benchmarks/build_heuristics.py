@@ -1,42 +1,49 @@
-import os
+import argparse
 import sys
 
 from timer import SimpleTimer
 
+from convtools._heuristics import (
+    WEIGHT_BENCHMARKS,
+    save_weights,
+    weights_from_times,
+)
 
-def print_new_weights():  # pragma: no cover
 
-    config = {
-        "LOGICAL": SimpleTimer("x or y", "x=0; y=1"),
-        "DICT_LOOKUP": SimpleTimer("d['abc']", "d = {'abc': 1}"),
-        "MATH_SIMPLE": SimpleTimer("x / y", "x=1;y=2"),
-        "ATTR_LOOKUP": SimpleTimer("A.b", "class A: b = 1"),
-        "TUPLE_INIT": SimpleTimer("(x,2,3,4,5)", "x=1"),
-        "LIST_INIT": SimpleTimer("[1,2,3,4,5]"),
-        "SET_INIT": SimpleTimer("{1,2,3,4,5}"),
-        "DICT_INIT": SimpleTimer("{'a': 1, 'b': 2, 'c': 3, 'd': 4, 'e': 5}"),
-    }
+def measure_weights():  # pragma: no cover
     print("# CALCULATING BASE TIME")
     base_time = SimpleTimer.get_base_time() / 100.0
 
+    name_to_time = {}
+    for name, (stmt, setup) in WEIGHT_BENCHMARKS.items():
+        iterations, time_taken = SimpleTimer(stmt, setup).auto_measure()
+        name_to_time[name] = time_taken / iterations
+    return base_time, weights_from_times(base_time, name_to_time)
+
+
+def print_new_weights(base_time, weights):  # pragma: no cover
     print(f"# {'.'.join(map(str, sys.version_info[:3]))}")
     print(
         "class Weights:  #type: ignore # pragma: no cover "
         "# pylint: disable=missing-class-docstring # noqa: F811"
     )
     print(f"    # base_time: {base_time}")
-    print("    STEP = 100")
-
-    max_it = 1
-    for name, timer in config.items():
-        iterations, time_taken = timer.auto_measure()
-        it = int(time_taken / iterations / base_time)
-        print(f"    {name} = {it}")
-        max_it = max(max_it, it)
-
-    print("    FUNCTION_CALL = DICT_LOOKUP * 4")
-    print(f"    UNPREDICTABLE = {max_it * 100}")
+    for name, value in weights.items():
+        print(f"    {name} = {value}")
 
 
 if __name__ == "__main__":
-    print_new_weights()  # pragma: no cover
+    parser = argparse.ArgumentParser(
+        description=(
+            "Measure weights of the current interpreter; "
+            "--save writes them to a file to be used via "
+            "PY_CONVTOOLS_WEIGHTS_FILE"
+        )
+    )
+    parser.add_argument("--save", metavar="PATH", default=None)
+    args = parser.parse_args()
+
+    base_time, weights = measure_weights()  # pragma: no cover
+    print_new_weights(base_time, weights)  # pragma: no cover
+    if args.save:
+        save_weights(args.save, weights)  # pragma: no cover
@@ -0,0 +1,83 @@
+"""Compare converters with and without common subexpression elimination.
+
+python benchmarks/cse.py
+"""
+
+from random import random, seed
+from timeit import Timer
+
+from convtools import conversion as c
+
+
+seed(1)
+
+DATA = [
+    {
+        "payload": {
+            "user": {
+                "id": i,
+                "name": f"user{i}",
+                "address": {"city": "Paris", "zip": str(i)},
+            },
+            "order": {"price": random(), "quantity": i % 3},
+        }
+    }
+    for i in range(10000)
+]
+
+WORKLOADS = {
+    "same lookup twice": c.iter(
+        (c.item("payload", "user", "id"), c.item("payload", "user", "id"))
+    ).as_type(list),
+    "shared prefix": c.iter(
+        {
+            "id": c.item("payload", "user", "id"),
+            "name": c.item("payload", "user", "name"),
+            "city": c.item("payload", "user", "address", "city"),
+            "zip": c.item("payload", "user", "address", "zip"),
+        }
+    ).as_type(list),
+    "filter + shared prefix": c.iter(
+        {
+            "id": c.item("payload", "user", "id"),
+            "total": c.item("payload", "order", "price")
+            * c.item("payload", "order", "quantity"),
+        },
+        where=c.item("payload", "order", "quantity") > 0,
+    ).as_type(list),
+    "dict comprehension": c.dict_comp(
+        c.item("payload", "user", "id"),
+        (
+            c.item("payload", "user", "name"),
+            c.item("payload", "user", "address", "city"),
+        ),
+    ),
+}
+
+
+def measure(converter, number=20):
+    return (
+        min(Timer(lambda: converter(DATA)).repeat(repeat=5, number=number))
+        / number
+    )
+
+
+def run():
+    for name, conversion in WORKLOADS.items():
+        with c.CodeGenerationOptionsCtx() as options:
+            options.common_subexpressions = False
+            plain = conversion.gen_converter()
+        hoisted = conversion.gen_converter()
+        assert plain(DATA) == hoisted(DATA)
+
+        plain_time = measure(plain)
+        hoisted_time = measure(hoisted)
+        print(
+            f"{name:24} without: {plain_time * 1000:.3f}ms "
+            f"with: {hoisted_time * 1000:.3f}ms "
+            f"({plain_time / hoisted_time:.2f}x)"
+        )
+
+
+if __name__ == "__main__":
+    run()
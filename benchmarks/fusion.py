@@ -0,0 +1,60 @@
+"""Compare fused pipelines with nested generators.
+
+python benchmarks/fusion.py
+"""
+
+from random import random, seed
+from timeit import Timer
+
+from convtools import conversion as c
+
+
+seed(1)
+
+DATA = [
+    {"order": {"price": random(), "quantity": i % 3, "user_id": i % 1000}}
+    for i in range(1000000)
+]
+
+WORKLOADS = {
+    "iter + filter": c.iter(c.item("order"))
+    .filter(c.item("quantity") > 0)
+    .as_type(list),
+    "iter + filter x2": c.iter(c.item("order"))
+    .filter(c.item("quantity") > 0)
+    .iter(c.item("price") * c.item("quantity"))
+    .filter(c.this > 0.5)
+    .as_type(list),
+    "pipe + sum": c.iter(c.item("order"))
+    .pipe(c.filter(c.item("user_id") < 500))
+    .pipe(c.iter(c.item("price") * c.item("quantity")))
+    .pipe(sum),
+}
+
+
+def measure(converter, number=3):
+    return (
+        min(Timer(lambda: converter(DATA)).repeat(repeat=5, number=number))
+        / number
+    )
+
+
+def run():
+    for name, conversion in WORKLOADS.items():
+        with c.CodeGenerationOptionsCtx() as options:
+            options.fuse_pipelines = False
+            nested = conversion.gen_converter()
+        fused = conversion.gen_converter()
+        assert nested(DATA) == fused(DATA)
+
+        nested_time = measure(nested)
+        fused_time = measure(fused)
+        print(
+            f"{name:18} nested: {nested_time * 1000:.1f}ms "
+            f"fused: {fused_time * 1000:.1f}ms "
+            f"({nested_time / fused_time:.2f}x)"
+        )
+
+
+if __name__ == "__main__":
+    run()
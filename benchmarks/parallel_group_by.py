@@ -0,0 +1,64 @@
+"""Measure scaling of parallel group by with the number of workers.
+
+python benchmarks/parallel_group_by.py [number of rows]
+"""
+
+import os
+import sys
+from random import random, seed
+from time import perf_counter
+
+from convtools import conversion as c
+
+
+seed(1)
+
+ROWS = int(sys.argv[1]) if len(sys.argv) > 1 else 2000000
+DATA = [
+    (i % 10000, random(), i % 7 if i % 11 else None) for i in range(ROWS)
+]
+WORKERS = (1, 2, 4, 8, 16)
+BATCH_SIZE = 250000
+
+
+def gen_converter(parallel):
+    return (
+        c.group_by(c.item(0))
+        .aggregate(
+            {
+                "key": c.item(0),
+                "sum": c.ReduceFuncs.Sum(c.item(1)),
+                "max": c.ReduceFuncs.Max(c.item(1)),
+                "count": c.ReduceFuncs.Count(c.item(2)),
+                "distinct": c.ReduceFuncs.CountDistinct(c.item(2)),
+            },
+            parallel=parallel,
+            batch_size=BATCH_SIZE,
+        )
+        .gen_converter()
+    )
+
+
+def measure(converter, repeat=3):
+    times = []
+    for _ in range(repeat):
+        time_start = perf_counter()
+        converter(DATA)
+        times.append(perf_counter() - time_start)
+    return min(times)
+
+
+def run():
+    print(f"rows: {ROWS}, cpus: {os.cpu_count()}")
+    base_time = measure(gen_converter(None))
+    print(f"{'sequential':>10}: {base_time:.3f}s")
+    for workers in WORKERS:
+        parallel_time = measure(gen_converter(workers))
+        print(
+            f"{workers:>10}: {parallel_time:.3f}s "
+            f"({base_time / parallel_time:.2f}x)"
+        )
+
+
+if __name__ == "__main__":
+    run()
@@ -0,0 +1,96 @@
+"""Measure cold start of a process, which generates many converters.
+
+python benchmarks/startup.py [number_of_conversions]
+"""
+
+import os
+import subprocess
+import sys
+import tempfile
+
+
+SCRIPT = """
+import gc
+import sys
+import tracemalloc
+from time import perf_counter
+
+from convtools import conversion as c
+
+number, mode, trace_memory = int(sys.argv[1]), sys.argv[2], sys.argv[3] == "1"
+conversions = {
+    f"converter{i}": c.group_by(c.item("key", i % 7)).aggregate(
+        {
+            "key": c.item("key", i % 7),
+            "total": c.ReduceFuncs.Sum(c.item("value") * (i + 1)),
+            "max": c.ReduceFuncs.Max(c.item("value"), where=c.item("ok")),
+            "items": c.ReduceFuncs.Array(c.item("name", default=str(i))),
+        }
+    ).pipe(
+        c.iter({"k": c.item("key"), "t": c.item("total") + i}).as_type(list)
+    )
+    for i in range(number)
+}
+
+if trace_memory:
+    tracemalloc.start()
+ts = perf_counter()
+if mode == "batch":
+    converters = c.gen_converters(conversions)
+else:
+    converters = {
+        name: conversion.gen_converter()
+        for name, conversion in conversions.items()
+    }
+took = perf_counter() - ts
+if trace_memory:
+    # memory held, not garbage waiting for collection
+    gc.collect()
+print(tracemalloc.get_traced_memory()[0] if trace_memory else took)
+"""
+
+
+def measure(number, mode="single", cache_dir=None, trace_memory=False):
+    env = dict(os.environ)
+    env.pop("PY_CONVTOOLS_BYTECODE_CACHE_DIR", None)
+    if cache_dir:
+        env["PY_CONVTOOLS_BYTECODE_CACHE_DIR"] = cache_dir
+    return float(
+        subprocess.check_output(
+            [
+                sys.executable,
+                "-c",
+                SCRIPT,
+                str(number),
+                mode,
+                "1" if trace_memory else "0",
+            ],
+            env=env,
+            text=True,
+        )
+    )
+
+
+def run(number=300):
+    no_cache = min(measure(number) for _ in range(3))
+    with tempfile.TemporaryDirectory() as cache_dir:
+        cold = measure(number, cache_dir=cache_dir)
+        warm = min(measure(number, cache_dir=cache_dir) for _ in range(3))
+    batch = min(measure(number, "batch") for _ in range(3))
+    memory = measure(number, trace_memory=True)
+    batch_memory = measure(number, "batch", trace_memory=True)
+
+    print(f"conversions:     {number}")
+    print(f"no cache:        {no_cache:.3f}s")
+    print(f"cold disk cache: {cold:.3f}s")
+    print(f"warm disk cache: {warm:.3f}s ({no_cache / warm:.2f}x)")
+    print(f"batch compile:   {batch:.3f}s ({no_cache / batch:.2f}x)")
+    print(f"memory held:     {memory / 2**20:.2f}MiB")
+    print(
+        f"batch memory:    {batch_memory / 2**20:.2f}MiB "
+        f"({memory / batch_memory:.2f}x)"
+    )
+
+
+if __name__ == "__main__":
+    run(*map(int, sys.argv[1:]))
@@ -8,7 +8,9 @@ from benchmarks.benchmarks import (
     DatetimeFormat,
     DatetimeParse,
     GroupBy1,
+    IterFilterChain1,
     IterOfIter1,
+    NestedDictLookups1,
     TableDictReader,
 )
 from benchmarks.storage import BenchmarkResultsStorage
@@ -20,7 +22,9 @@ BENCHMARKS = [
     Aggregate1(),
     GroupBy1(GroupBy1.Modes.FEW_GROUPS),
     GroupBy1(GroupBy1.Modes.MANY_GROUPS),
+    IterFilterChain1(),
     IterOfIter1(),
+    NestedDictLookups1(),
     TableDictReader(),
     type("DateParse1", (DateParse,), {"FMT": "%m/%d/%Y"})(),
     type("DateParse2", (DateParse,), {"FMT": "%Y-%m-%d"})(),
@@ -1,11 +1,29 @@
 """Define aggregations with various reduce functions."""
 
+import gc
+import multiprocessing
+import os
+import pickle
+import tempfile
+import threading
 import warnings
+import weakref
 from collections import defaultdict
 from decimal import Decimal
-from itertools import chain
+from functools import partial
+from heapq import nlargest
+from itertools import chain, count, islice
 from math import ceil
-from typing import Any, Callable, ClassVar, Dict, Sequence, Tuple, Union
+from typing import (
+    Any,
+    Callable,
+    ClassVar,
+    Dict,
+    Optional,
+    Sequence,
+    Tuple,
+    Union,
+)
 
 from ._base import (
     BaseConversion,
@@ -13,6 +31,7 @@ from ._base import (
     ConversionException,
     ConverterOptionsCtx,
     EscapedString,
+    GeneratorComp,
     GeneratorItem,
     GetItem,
     If,
@@ -23,12 +42,14 @@ from ._base import (
     NaiveConversion,
     Namespace,
     NamespaceCtx,
+    PipeConversion,
     This,
     Tuple_,
     _None,
     _none,
 )
 from ._heuristics import Weights
+from ._sketches import KLL, FrequentItems, HyperLogLog
 from ._utils import Code
 
 
@@ -86,26 +107,47 @@ class ReduceManager:
         "number",
         "reduce_code",
         "used_indexes",
+        "merge_mode",
+        "merge_items",
+        "stateful",
     ]
 
-    def __init__(self, var_row, var_agg_data, aggregate_mode):
+    def __init__(
+        self,
+        var_row,
+        var_agg_data,
+        aggregate_mode,
+        merge_mode=False,
+        stateful=False,
+    ):
         self.var_row = var_row
         self.var_agg_data = var_agg_data
         self.aggregate_mode = aggregate_mode
         self.number = 0
         self.reduce_code = ReduceCode()
         self.used_indexes = []
+        self.merge_mode = merge_mode
+        # (agg data value, merge lines) of used indexes, filled in merge mode
+        self.merge_items = []
+        self.stateful = stateful
 
     def gen_group_by_code(self, var_signature_to_agg_data, code_signature):
         code = Code()
         code.add_line(f"for {self.var_row} in data_:", 1)
-        code.add_line(
-            f"{self.var_agg_data} = {var_signature_to_agg_data}[{code_signature}]",
-            0,
-        )
-        self.add_group_by_code(code, self.reduce_code)
+        self.add_row_code(code, var_signature_to_agg_data, code_signature)
         return code
 
+    def add_row_code(
+        self, code: Code, var_signature_to_agg_data=None, code_signature=None
+    ):
+        """Add code, which processes a single row, to a loop body."""
+        if not self.aggregate_mode:
+            code.add_line(
+                f"{self.var_agg_data} = {var_signature_to_agg_data}[{code_signature}]",
+                0,
+            )
+        self.add_group_by_code(code, self.reduce_code)
+
     def gen_aggregate_code(self):
         var_init_checksum = "checksum_"
         code = Code()
@@ -154,9 +196,48 @@ class ReduceManager:
                 code.add_line(f"self.{attr} = _none", 0)
         else:
             code.add_line("pass", 0)
-        return ctx[
-            grouper.compile_converter(container_name, code.to_string(0), ctx)
-        ]
+        return grouper.compile_converter(
+            container_name, code.to_string(0), ctx
+        )
+
+    def gen_states_code(self):
+        """Return code of a tuple of partial states of used reducers."""
+        if not self.used_indexes:
+            return "()"
+        _ = ", ".join(
+            self.fmt_agg_data_value(index) for index in self.used_indexes
+        )
+        return f"({_},)"
+
+    def gen_signature_to_states_code(
+        self, var_signature, var_signature_to_agg_data
+    ):
+        """Return code of a dict of group keys to partial states."""
+        return (
+            f"{{{var_signature}: {self.gen_states_code()} for "
+            f"{var_signature}, {self.var_agg_data} in "
+            f"{var_signature_to_agg_data}.items()}}"
+        )
+
+    def gen_merge_code(self, var_states):
+        """Generate code, which merges a tuple of partial states in."""
+        code = Code()
+        for position, (var_agg_data_value, merge_lines) in enumerate(
+            self.merge_items
+        ):
+            code.add_line(f"state_ = {var_states}[{position}]", 0)
+            code.add_line("if state_ is not _none:", 1)
+            code.add_line(f"if {var_agg_data_value} is _none:", 1)
+            code.add_line(f"{var_agg_data_value} = state_", -1)
+            if merge_lines:
+                code.add_line("else:", 1)
+                for line in merge_lines:
+                    code.add_line(line, 0)
+                code.incr_indent_level(-1)
+            code.incr_indent_level(-1)
+        if not code.lines_info:
+            code.add_line("pass", 0)
+        return code
 
     def gen_init_aggregate_vars(self):
         if not self.used_indexes:
@@ -265,7 +346,17 @@ class ReduceManager:
 
 
 class BaseReducer(BaseConversion):
-    """Base reduce operation to be used during the aggregation."""
+    """Base reduce operation to be used during the aggregation.
+
+    A reducer keeps a partial state, which is:
+     * initialized from the first value by ``prepare_first_lines``
+     * folded with further values by ``reduce_lines``
+     * merged with another partial state by ``merge_lines``, so
+       aggregations can be split across batches / processes
+     * finalized by ``post_conversion`` (or replaced with ``default`` if
+       there was nothing to reduce); ``snapshot_post_conversion`` is used
+       instead by stateful aggregators, if finalization alters the state
+    """
 
     _expressions: Sequence[BaseConversion]
 
@@ -276,6 +367,10 @@ class BaseReducer(BaseConversion):
     works_with_not_none_only: Tuple[int, ...]
     prepare_first_lines: Union[Tuple[str, ...], Callable[[], Tuple[str, ...]]]
     reduce_lines: Union[Tuple[str, ...], Callable[[], Tuple[str, ...]]]
+    merge_lines: Union[
+        None, Tuple[str, ...], Callable[[], Optional[Tuple[str, ...]]]
+    ] = None
+    snapshot_post_conversion: Optional[BaseConversion] = None
     where: Union[_None, BaseConversion]
 
     self_content_type = (
@@ -309,6 +404,17 @@ class BaseReducer(BaseConversion):
                 (post_conversion if post_conversion is not None else This),
             )
         )
+        self.snapshot_conversion = (
+            self.conversion
+            if self.snapshot_post_conversion is None
+            else self.ensure_conversion(
+                If(
+                    This.is_(EscapedString("_none")),
+                    self.default,
+                    self.snapshot_post_conversion,
+                )
+            )
+        )
 
     def check_expressions(self):
         if not self.internals_are_public and not isinstance(
@@ -365,9 +471,38 @@ class BaseReducer(BaseConversion):
         )
         if proposed_code_input == new_code_input:
             reduce_manager.used_indexes.append(index)
+            if reduce_manager.merge_mode:
+                reduce_manager.merge_items.append(
+                    (
+                        new_code_input,
+                        tuple(
+                            line
+                            % {"result": new_code_input, "other": "state_"}
+                            for line in self.get_merge_lines(ctx)
+                        ),
+                    )
+                )
 
+        if reduce_manager.stateful:
+            return self.snapshot_conversion.gen_code_and_update_ctx(
+                new_code_input, ctx
+            )
         return self.conversion.gen_code_and_update_ctx(new_code_input, ctx)
 
+    def get_merge_lines(self, ctx):
+        merge_lines = self.get_option("merge_lines", ctx)
+        if merge_lines is None:
+            raise ValueError(
+                f"{self.__class__.__name__} doesn't support merging "
+                "partial states"
+            )
+        if not isinstance(self.initial, _None):
+            raise ValueError(
+                "partial states of reducers with initial cannot be merged, "
+                "since initial would be accounted for multiple times"
+            )
+        return merge_lines
+
     def update_reduce_code(
         self,
         reduce_code: ReduceCode,
@@ -509,6 +644,8 @@ class SumReducer(SingleExpressionReducer):
             return ("%(result)s += %(value0)s",)
         return ("%(result)s += %(value0)s or 0",)
 
+    merge_lines = ("%(result)s += %(other)s",)
+
 
 class SumOrNoneReducer(SingleExpressionReducer):
     """Take a sum. If at least one None is met, the result is None."""
@@ -517,6 +654,12 @@ class SumOrNoneReducer(SingleExpressionReducer):
     internals_are_public = True
     works_with_not_none_only = (False,)
     prepare_first_lines = ("%(result)s = %(value0)s",)
+    merge_lines = (
+        "if %(other)s is None:",
+        "    %(result)s = None",
+        "elif %(result)s is not None:",
+        "    %(result)s += %(other)s",
+    )
 
     def values_use_times(self, ctx):  # pylint: disable=unused-argument
         if self.expressions[0].has_hint(BaseConversion.OutputHints.NOT_NONE):
@@ -544,6 +687,10 @@ class MaxReducer(SingleExpressionReducer):
         "if %(result)s < %(value0)s:",
         "    %(result)s = %(value0)s",
     )
+    merge_lines = (
+        "if %(result)s < %(other)s:",
+        "    %(result)s = %(other)s",
+    )
 
 
 class MinReducer(SingleExpressionReducer):
@@ -556,6 +703,10 @@ class MinReducer(SingleExpressionReducer):
         "if %(result)s > %(value0)s:",
         "    %(result)s = %(value0)s",
     )
+    merge_lines = (
+        "if %(result)s > %(other)s:",
+        "    %(result)s = %(other)s",
+    )
 
 
 class CountReducer(OptionalExpressionReducer):
@@ -571,6 +722,7 @@ class CountReducer(OptionalExpressionReducer):
     values_use_times = (0,)
     prepare_first_lines = ("%(result)s = 1",)
     reduce_lines = ("%(result)s += 1",)
+    merge_lines = ("%(result)s += %(other)s",)
 
     def works_with_not_none_only(self, ctx):  # pylint: disable=unused-argument
         if len(self.expressions) == 1 and not self.expressions[0].has_hint(
@@ -587,9 +739,39 @@ class CountDistinctReducer(SingleExpressionReducer):
     works_with_not_none_only = (False,)
     prepare_first_lines = ("%(result)s = {%(value0)s}",)
     reduce_lines = ("%(result)s.add(%(value0)s)",)
+    merge_lines = ("%(result)s.update(%(other)s)",)
     post_conversion = CallFunc(len, This)
 
 
+class ApproxCountDistinctReducer(SingleExpressionReducer):
+    """Estimate the number of distinct values with HyperLogLog.
+
+    Unlike ``CountDistinct``, the state is a fixed ``2 ** precision`` bytes
+    per group; the relative standard error is ``1.04 / sqrt(2 **
+    precision)``: ~1.6% for the default precision of 12.
+    """
+
+    default = NaiveConversion(0)
+    internals_are_public = False
+    values_use_times = (1,)
+    works_with_not_none_only = (False,)
+    reduce_lines = ("%(result)s.add(%(value0)s)",)
+    merge_lines = ("%(result)s.merge(%(other)s)",)
+    post_conversion = This.call_method("count")
+
+    def __init__(self, *args, precision=12, **kwargs):
+        # fails early on bad precision
+        HyperLogLog(precision)
+        self.precision = precision
+        super().__init__(*args, **kwargs)
+
+    def prepare_first_lines(self, ctx):  # pylint: disable=unused-argument
+        return (
+            f"%(result)s = HyperLogLog({self.precision})",
+            "%(result)s.add(%(value0)s)",
+        )
+
+
 class FirstReducer(SingleExpressionReducer):
     default = NaiveConversion(None)
     internals_are_public = False
@@ -597,6 +779,7 @@ class FirstReducer(SingleExpressionReducer):
     works_with_not_none_only = (False,)
     prepare_first_lines = ("%(result)s = %(value0)s",)
     reduce_lines = ()
+    merge_lines = ()
 
 
 class LastReducer(SingleExpressionReducer):
@@ -606,6 +789,7 @@ class LastReducer(SingleExpressionReducer):
     works_with_not_none_only = (False,)
     prepare_first_lines = ("%(result)s = %(value0)s",)
     reduce_lines = ("%(result)s = %(value0)s",)
+    merge_lines = ("%(result)s = %(other)s",)
 
 
 class MaxRowReducer(SingleExpressionReducer):
@@ -620,6 +804,10 @@ class MaxRowReducer(SingleExpressionReducer):
         "if %(result)s[0] < %(value0)s:",
         "    %(result)s = (%(value0)s, %(row)s)",
     )
+    merge_lines = (
+        "if %(result)s[0] < %(other)s[0]:",
+        "    %(result)s = %(other)s",
+    )
     post_conversion = GetItem(1)
 
 
@@ -635,6 +823,10 @@ class MinRowReducer(SingleExpressionReducer):
         "if %(result)s[0] > %(value0)s:",
         "    %(result)s = (%(value0)s, %(row)s)",
     )
+    merge_lines = (
+        "if %(result)s[0] > %(other)s[0]:",
+        "    %(result)s = %(other)s",
+    )
     post_conversion = GetItem(1)
 
     def check_expressions(self):
@@ -648,6 +840,15 @@ class MinRowReducer(SingleExpressionReducer):
             )
 
 
+lock_default_dict_conversion = InlineExpr(
+    'setattr({this_}, "default_factory", None) or {this_}'
+).pass_args(this_=This)
+# leaves the defaultdict intact, so it can be reduced to further
+copy_default_dict_conversion = CallFunc(dict, This)
+# snapshots don't share containers with the state, which keeps changing
+copy_list_conversion = CallFunc(list, This)
+
+
 class ArrayReducer(SingleExpressionReducer):
     default = NaiveConversion(None)
     internals_are_public = True
@@ -655,25 +856,27 @@ class ArrayReducer(SingleExpressionReducer):
     works_with_not_none_only = (False,)
     prepare_first_lines = ("%(result)s = [%(value0)s]",)
     reduce_lines = ("%(result)s.append(%(value0)s)",)
+    merge_lines = ("%(result)s.extend(%(other)s)",)
+    snapshot_post_conversion = copy_list_conversion
 
 
 class ListSortedOnceWrapper:
-    """Wrap list, which is sorted only once."""
+    """Wrap list, which is sorted only once unless appended to afterwards."""
 
-    __slots__ = ["list_", "append", "sorted", "key", "reverse"]
+    __slots__ = ["list_", "append", "sorted_len", "key", "reverse"]
 
     def __init__(self, list_: list, key=None, reverse=False):
         self.list_ = list_
         self.append = self.list_.append
-        self.sorted = False
+        self.sorted_len = -1
         self.key = key
         self.reverse = reverse
 
     def get(self) -> list:
-        if not self.sorted:
+        # only appends and extends are expected, so length tells changes
+        if self.sorted_len != len(self.list_):
             self.list_.sort(key=self.key, reverse=self.reverse)
-            self.sorted = True
-            del self.append
+            self.sorted_len = len(self.list_)
         return self.list_
 
 
@@ -685,7 +888,11 @@ class SortedArrayReducer(SingleExpressionReducer):
     values_use_times = (1,)
     works_with_not_none_only = (False,)
     reduce_lines = ("%(result)s.append(%(value0)s)",)
+    merge_lines = ("%(result)s.list_.extend(%(other)s.list_)",)
     post_conversion = This.call_method("get")
+    snapshot_post_conversion = This.call_method("get").pipe(
+        copy_list_conversion
+    )
 
     def __init__(self, *args, key=None, reverse=False, **kwargs):
         super().__init__(*args, **kwargs)
@@ -708,6 +915,7 @@ class ArrayDistinctReducer(SingleExpressionReducer):
     works_with_not_none_only = (False,)
     prepare_first_lines = ("%(result)s = { %(value0)s: None }",)
     reduce_lines = ("%(result)s[%(value0)s] = None",)
+    merge_lines = ("%(result)s.update(%(other)s)",)
     post_conversion = This.as_type(list)
 
 
@@ -724,11 +932,8 @@ class DictReducer(BaseDictReducer):
     works_with_not_none_only = (False, False)
     prepare_first_lines = ("%(result)s = { %(value0)s: %(value1)s }",)
     reduce_lines = ("%(result)s[%(value0)s] = %(value1)s",)
-
-
-lock_default_dict_conversion = InlineExpr(
-    'setattr({this_}, "default_factory", None) or {this_}'
-).pass_args(this_=This)
+    merge_lines = ("%(result)s.update(%(other)s)",)
+    snapshot_post_conversion = copy_default_dict_conversion
 
 
 class DictArrayReducer(BaseDictReducer):
@@ -747,7 +952,14 @@ class DictArrayReducer(BaseDictReducer):
         "%(result)s[%(value0)s].append(%(value1)s)",
     )
     reduce_lines = ("%(result)s[%(value0)s].append(%(value1)s)",)
+    merge_lines = (
+        "for k_, v_ in %(other)s.items():",
+        "    %(result)s[k_].extend(v_)",
+    )
     post_conversion = lock_default_dict_conversion
+    snapshot_post_conversion = InlineExpr(
+        "{{k_: list(v_) for k_, v_ in {}.items()}}"
+    ).pass_args(This)
 
 
 class DictArrayDistinctReducer(BaseDictReducer):
@@ -766,6 +978,10 @@ class DictArrayDistinctReducer(BaseDictReducer):
         "%(result)s[%(value0)s][%(value1)s] = None",
     )
     reduce_lines = ("%(result)s[%(value0)s][%(value1)s] = None",)
+    merge_lines = (
+        "for k_, v_ in %(other)s.items():",
+        "    %(result)s[k_].update(v_)",
+    )
     post_conversion = InlineExpr(
         "{{k_: list(v_) for k_, v_ in {}.items()}}"
     ).pass_args(This)
@@ -787,7 +1003,12 @@ class DictSumReducer(BaseDictReducer):
         "%(result)s = defaultdict(int)",
         "%(result)s[%(value0)s] = %(value1)s or 0",
     )
+    merge_lines = (
+        "for k_, v_ in %(other)s.items():",
+        "    %(result)s[k_] += v_",
+    )
     post_conversion = lock_default_dict_conversion
+    snapshot_post_conversion = copy_default_dict_conversion
 
     def reduce_lines(self, ctx):  # pylint: disable=unused-argument
         if self.expressions[1].has_hint(BaseConversion.OutputHints.NOT_NONE):
@@ -810,7 +1031,15 @@ class DictSumOrNoneReducer(BaseDictReducer):
         "%(result)s = defaultdict(int)",
         "%(result)s[%(value0)s] = %(value1)s",
     )
+    merge_lines = (
+        "for k_, v_ in %(other)s.items():",
+        "    if v_ is None or k_ not in %(result)s:",
+        "        %(result)s[k_] = v_",
+        "    elif %(result)s[k_] is not None:",
+        "        %(result)s[k_] += v_",
+    )
     post_conversion = lock_default_dict_conversion
+    snapshot_post_conversion = copy_default_dict_conversion
 
     def values_use_times(self, ctx):  # pylint: disable=unused-argument
         if self.expressions[1].has_hint(BaseConversion.OutputHints.NOT_NONE):
@@ -837,6 +1066,7 @@ class DictMaxReducer(BaseDictReducer):
 
     default = NaiveConversion(None)
     internals_are_public = False
+    snapshot_post_conversion = copy_default_dict_conversion
     values_use_times = (1, 1)
     prepare_first_lines = ("%(result)s = { %(value0)s: %(value1)s }",)
 
@@ -851,6 +1081,12 @@ class DictMaxReducer(BaseDictReducer):
             "    %(result)s[%(value0)s] = %(value1)s",
         )
 
+    merge_lines = (
+        "for k_, v_ in %(other)s.items():",
+        "    if k_ not in %(result)s or v_ > %(result)s[k_]:",
+        "        %(result)s[k_] = v_",
+    )
+
 
 class DictMinReducer(BaseDictReducer):
     """Reduce two values to a dict.
@@ -861,6 +1097,7 @@ class DictMinReducer(BaseDictReducer):
 
     default = NaiveConversion(None)
     internals_are_public = False
+    snapshot_post_conversion = copy_default_dict_conversion
     values_use_times = (1, 1)
     prepare_first_lines = ("%(result)s = { %(value0)s: %(value1)s }",)
 
@@ -875,6 +1112,12 @@ class DictMinReducer(BaseDictReducer):
             "    %(result)s[%(value0)s] = %(value1)s",
         )
 
+    merge_lines = (
+        "for k_, v_ in %(other)s.items():",
+        "    if k_ not in %(result)s or v_ < %(result)s[k_]:",
+        "        %(result)s[k_] = v_",
+    )
+
 
 class DictCountReducer(BaseDictReducer):
     """Reduce two values to a dict.
@@ -887,6 +1130,7 @@ class DictCountReducer(BaseDictReducer):
 
     default = NaiveConversion(None)
     internals_are_public = False
+    snapshot_post_conversion = copy_default_dict_conversion
     values_use_times = (2, 0)
     prepare_first_lines = ("%(result)s = { %(value0)s: 1 }",)
     reduce_lines = (
@@ -895,6 +1139,13 @@ class DictCountReducer(BaseDictReducer):
         "else:",
         "    %(result)s[%(value0)s] += 1",
     )
+    merge_lines = (
+        "for k_, v_ in %(other)s.items():",
+        "    if k_ not in %(result)s:",
+        "        %(result)s[k_] = v_",
+        "    else:",
+        "        %(result)s[k_] += v_",
+    )
 
     def check_expressions(self):
         BaseReducer.check_expressions(self)
@@ -939,6 +1190,13 @@ class DictCountDistinctReducer(BaseDictReducer):
         "else:",
         "    %(result)s[%(value0)s].add(%(value1)s)",
     )
+    merge_lines = (
+        "for k_, v_ in %(other)s.items():",
+        "    if k_ not in %(result)s:",
+        "        %(result)s[k_] = v_",
+        "    else:",
+        "        %(result)s[k_].update(v_)",
+    )
     post_conversion = InlineExpr(
         "{{ k_: len(v_) for k_, v_ in {}.items() }}"
     ).pass_args(This)
@@ -953,6 +1211,7 @@ class DictFirstReducer(BaseDictReducer):
 
     default = NaiveConversion(None)
     internals_are_public = False
+    snapshot_post_conversion = copy_default_dict_conversion
     values_use_times = (2, 1)
     works_with_not_none_only = (False, False)
     prepare_first_lines = ("%(result)s = { %(value0)s: %(value1)s }",)
@@ -960,6 +1219,11 @@ class DictFirstReducer(BaseDictReducer):
         "if %(value0)s not in %(result)s:",
         "    %(result)s[%(value0)s] = %(value1)s",
     )
+    merge_lines = (
+        "for k_, v_ in %(other)s.items():",
+        "    if k_ not in %(result)s:",
+        "        %(result)s[k_] = v_",
+    )
 
 
 class DictLastReducer(BaseDictReducer):
@@ -971,10 +1235,12 @@ class DictLastReducer(BaseDictReducer):
 
     default = NaiveConversion(None)
     internals_are_public = False
+    snapshot_post_conversion = copy_default_dict_conversion
     values_use_times = (1, 1)
     works_with_not_none_only = (False, False)
     prepare_first_lines = ("%(result)s = { %(value0)s: %(value1)s }",)
     reduce_lines = ("%(result)s[%(value0)s] = %(value1)s",)
+    merge_lines = ("%(result)s.update(%(other)s)",)
 
 
 class ReducerDispatcher:
@@ -1010,6 +1276,9 @@ class TopReducer(DictCountReducer):
     The resulting list is sorted in descending order of value frequency.
     """
 
+    # post_conversion builds a new value, so snapshots don't need a copy
+    snapshot_post_conversion = None
+
     def __init__(self, k: int, key_conv, *args, **kwargs):
         if not isinstance(k, int):
             raise TypeError("K must be an integer.")
@@ -1020,20 +1289,71 @@ class TopReducer(DictCountReducer):
         self.k = k
         super().__init__(key_conv, *args, **kwargs)
 
+    @staticmethod
+    def top_k(value_to_count, k):
+        # the same output as the former full sort of (count, value) pairs,
+        # whose first items were taken, but O(n log k)
+        return nlargest(k, value_to_count.values())
+
     def post_conversion(self, ctx):  # pylint: disable=unused-argument
-        return InlineExpr(
-            "[key for key, value in sorted((v, k) for k, v in {data}.items())[:-{k}:-1]]"
-        ).pass_args(data=This, k=self.k + 1)
+        return CallFunc(self.top_k, This, self.k)
+
+
+class ApproxTopReducer(SingleExpressionReducer):
+    """Return a list of the most frequent values in bounded memory.
+
+    Values are counted by a Misra-Gries sketch of up to ``capacity``
+    counters per group, so any value more frequent than ``2 / capacity`` of
+    the reduced values is reported; those below are dropped first. The
+    resulting list is sorted in descending order of estimated frequency.
+    """
+
+    default = NaiveConversion(None)
+    internals_are_public = False
+    values_use_times = (1,)
+    works_with_not_none_only = (False,)
+    reduce_lines = ("%(result)s.add(%(value0)s)",)
+    merge_lines = ("%(result)s.merge(%(other)s)",)
+
+    def __init__(self, k: int, conv, *args, capacity=1000, **kwargs):
+        if not isinstance(k, int):
+            raise TypeError("K must be an integer.")
+        if k < 1:
+            raise ValueError("K must be a positive integer greater than 0.")
+        # fails early on bad capacity
+        FrequentItems(capacity)
+        if capacity < k:
+            raise ValueError("capacity must not be less than K")
+        self.k = k
+        self.capacity = capacity
+        super().__init__(conv, *args, **kwargs)
+
+    def prepare_first_lines(self, ctx):  # pylint: disable=unused-argument
+        return (
+            f"%(result)s = FrequentItems({self.capacity})",
+            "%(result)s.add(%(value0)s)",
+        )
+
+    def post_conversion(self, ctx):  # pylint: disable=unused-argument
+        return This.call_method("top", self.k)
 
 
 class ModeReducer(DictCountReducer):
+    snapshot_post_conversion = None
+
     def __init__(self, conv, *args, **kwargs):
         super().__init__(conv, conv, *args, **kwargs)
 
-    # TODO: check how MaxRow performs here
-    post_conversion = InlineExpr(
-        "sorted({data}.items(), key=lambda x: x[1])[-1][0]"
-    ).pass_args(data=This)
+    @staticmethod
+    def mode(value_to_count):
+        # the last of the most common values, which is the one with the max
+        # (count, index) pair
+        return max(
+            zip(value_to_count.values(), count(), value_to_count)
+        )[-1]
+
+    def post_conversion(self, ctx):  # pylint: disable=unused-argument
+        return CallFunc(self.mode, This)
 
 
 class PercentileReducer(SortedArrayReducer):
@@ -1051,6 +1371,7 @@ class PercentileReducer(SortedArrayReducer):
     """
 
     interpolation_to_method: ClassVar[Dict[str, Callable]] = {}
+    snapshot_post_conversion = None
 
     def __init__(
         self, percentile: float, conv, *args, interpolation="linear", **kwargs
@@ -1144,6 +1465,51 @@ def MedianReducer(  # pylint:disable=invalid-name
     return PercentileReducer(50, conv, *args, **kwargs)
 
 
+class ApproxPercentileReducer(SingleExpressionReducer):
+    """Estimate percentile (float: from 0 to 100 inclusive) with KLL sketch.
+
+    Unlike ``Percentile``, which keeps all values, the state is bounded:
+    ~``3 * k`` values per group, normalized rank error is ~``2 / k``.
+    ``None`` values are skipped. Percentiles of the same value and ``k``
+    share the sketch.
+
+    >>> c.ReduceFuncs.ApproxPercentile(95, c.item("amount"), k=400)
+    """
+
+    default = NaiveConversion(None)
+    internals_are_public = False
+    values_use_times = (1,)
+    works_with_not_none_only = (True,)
+    reduce_lines = ("%(result)s.add(%(value0)s)",)
+    merge_lines = ("%(result)s.merge(%(other)s)",)
+
+    def __init__(self, percentile: float, conv, *args, k=200, **kwargs):
+        if not 0 <= percentile <= 100:
+            raise ValueError(
+                "percentile must be a float between 0 and 100 inclusive"
+            )
+        # fails early on bad k
+        KLL(k)
+        self.percentile = percentile
+        self.k = k
+        super().__init__(conv, *args, **kwargs)
+
+    def prepare_first_lines(self, ctx):  # pylint: disable=unused-argument
+        return (
+            f"%(result)s = KLL({self.k})",
+            "%(result)s.add(%(value0)s)",
+        )
+
+    def post_conversion(self, ctx):  # pylint: disable=unused-argument
+        return This.call_method("quantile", self.percentile / 100)
+
+
+def ApproxMedianReducer(  # pylint:disable=invalid-name
+    conv, *args, **kwargs
+) -> BaseConversion:
+    return ApproxPercentileReducer(50, conv, *args, **kwargs)
+
+
 class ReduceFuncs:
     """Expose the list of reduce functions."""
 
@@ -1168,6 +1534,8 @@ class ReduceFuncs:
     Count = CountReducer
     #: Counts distinct values
     CountDistinct = CountDistinctReducer
+    #: Estimates the number of distinct values (HyperLogLog)
+    ApproxCountDistinct = ApproxCountDistinctReducer
 
     #: Stores the first value per group
     First = FirstReducer
@@ -1180,12 +1548,19 @@ class ReduceFuncs:
     Median = MedianReducer
     #: Calculates percentile: floats in [0, 100]
     Percentile = PercentileReducer
+    #: Estimates the median value in bounded memory (KLL sketch)
+    ApproxMedian = ApproxMedianReducer
+    #: Estimates percentile in bounded memory (KLL sketch): floats in [0, 100]
+    ApproxPercentile = ApproxPercentileReducer
     #: Calculates the most common value.
     #: In case of multiple values, returns the last of them.
     Mode = ModeReducer
     #: Returns a list of the most frequent values.
     #: The resulting list is sorted in descending order of values frequency.
     TopK = TopReducer
+    #: Returns a list of the most frequent values in bounded memory
+    #: (Misra-Gries sketch), sorted in descending order of their frequency.
+    ApproxTop = ApproxTopReducer
 
     #: Aggregates values into array
     Array = ArrayReducer
@@ -1238,24 +1613,61 @@ class GroupBy:
      * using the same reducer twicewon't result in double calculation
     """
 
-    def __init__(self, *by):
+    def __init__(self, *by, presorted=False):
         """Accept keys of group by as conversions.
 
         Args:
           by (tuple): keys of group by as conversions. Each is to resolve to a
             hashable object. If nothing is passed, the result is a single
             object.
+          presorted: input is ordered by keys, so each group is finalized as
+            soon as keys change and results are lazy (an iterator)
         """
+        if presorted and not by:
+            raise ValueError("presorted requires keys to group by")
         self.by = by
+        self.presorted = presorted
 
     def aggregate(
-        self, reducer: Union[dict, list, set, tuple, BaseConversion]
+        self,
+        reducer: Union[dict, list, set, tuple, BaseConversion],
+        parallel: Optional[int] = None,
+        batch_size: int = 10000,
+        max_groups: Optional[int] = None,
+        spill_partitions: int = 16,
     ) -> "Grouper":
-        return Grouper(self.by, reducer)
+        """Define the result of the aggregation.
+
+        Args:
+          reducer: conversion, which contains reducers and group by keys
+          parallel: number of worker processes to aggregate batches of input
+            in, then partial states are merged in the current process. Rows
+            are to be picklable. All reducers are to support merging. The
+            pool is forked on the first call and reused, so the first call
+            is to be made before other threads start.
+          batch_size: number of rows in a batch sent to a worker process
+          max_groups: (group by only) number of groups to keep in memory,
+            once exceeded, partial states are spilled to temporary files,
+            hash-partitioned by group keys; then partitions are merged one
+            by one. All reducers are to support merging.
+          spill_partitions: number of partitions of spilled states
+        """
+        return Grouper(
+            self.by,
+            reducer,
+            parallel=parallel,
+            batch_size=batch_size,
+            max_groups=max_groups,
+            spill_partitions=spill_partitions,
+            presorted=self.presorted,
+        )
 
 
 def delegate_input_switching_method(name, force_iter_first=False):
     def method(self, *args, **kwargs):
+        if self.mode == Grouper.MODE_PARTIAL:
+            return getattr(super(Grouper, self), name)(*args, **kwargs)
+
         conversion = self.conversion
         if force_iter_first:
             conversion = conversion.to_iter()
@@ -1263,6 +1675,12 @@ def delegate_input_switching_method(name, force_iter_first=False):
             by=self.by,
             reducer=self.reducer,
             conversion=getattr(conversion, name)(*args, **kwargs),
+            mode=self.mode,
+            parallel=self.parallel,
+            batch_size=self.batch_size,
+            max_groups=self.max_groups,
+            spill_partitions=self.spill_partitions,
+            presorted=self.presorted,
         )
 
     return method
@@ -1282,6 +1700,98 @@ def {converter_name}({code_args}):
 
 {code_aggregate}
 
+{code_result}
+"""
+MERGE_GROUPER_TEMPLATE = """
+def {converter_name}({code_args}):
+    {var_signature_to_agg_data} = defaultdict({var_agg_data_cls})
+    for partial_ in data_:
+        for {var_signature}, states_ in partial_.items():
+            {var_agg_data} = {var_signature_to_agg_data}[{var_signature}]
+{code_merge}
+
+{code_result}
+"""
+PRESORTED_GROUPER_TEMPLATE = """
+def {converter_name}({code_args}):
+    def iter_groups_():
+        {var_signature} = {var_agg_data} = _none
+        for {var_row} in data_:
+            new_signature_ = {code_signature}
+            if new_signature_ != {var_signature}:
+                if {var_agg_data} is not _none:
+                    yield {var_signature}, {var_agg_data}
+                {var_signature} = new_signature_
+                {var_agg_data} = {var_agg_data_cls}()
+{code_reduce}
+        if {var_agg_data} is not _none:
+            yield {var_signature}, {var_agg_data}
+
+{code_result}
+"""
+SPILL_GROUPER_TEMPLATE = """
+def {converter_name}({code_args}):
+    {var_signature_to_agg_data} = defaultdict({var_agg_data_cls})
+    spiller_ = GroupsSpiller({spill_partitions})
+
+    def merge_spilled_():
+        for partials_ in spiller_.iter_partitions():
+            {var_signature_to_agg_data} = defaultdict({var_agg_data_cls})
+            for partial_ in partials_:
+                for {var_signature}, states_ in partial_.items():
+                    {var_agg_data} = {var_signature_to_agg_data}[{var_signature}]
+{code_merge}
+            yield from {var_signature_to_agg_data}.items()
+
+{code_group_by}
+
+    if spiller_.spilled:
+        spiller_.spill({code_states})
+        {var_signature_to_agg_data}.clear()
+        items_ = merge_spilled_()
+    else:
+        items_ = {var_signature_to_agg_data}.items()
+
+{code_result}
+"""
+STATEFUL_GROUPER_TEMPLATE = """
+def {converter_name}({code_args}):
+    {var_signature_to_agg_data} = defaultdict({var_agg_data_cls})
+
+    def update_(data_):
+{code_update}
+
+    def snapshot_():
+        return {code_final_result}
+
+    def reset_():
+        {var_signature_to_agg_data}.clear()
+
+    return Aggregator(update_, snapshot_, reset_)
+"""
+STATEFUL_AGGREGATE_TEMPLATE = """
+def {converter_name}({code_args}):
+    {code_init_agg_vars}
+
+    def update_(data_):
+        {code_nonlocal}
+{code_update}
+
+    def snapshot_():
+        return {code_final_result}
+
+    def reset_():
+        {code_nonlocal}
+        {code_reset}
+
+    return Aggregator(update_, snapshot_, reset_)
+"""
+MERGE_AGGREGATE_TEMPLATE = """
+def {converter_name}({code_args}):
+    {code_init_agg_vars}
+    for states_ in data_:
+{code_merge}
+
 {code_result}
 """
 
@@ -1312,19 +1822,61 @@ class Grouper(BaseConversion):
     )
     AGG_RESULT_ITEM.weight = Weights.UNPREDICTABLE
 
-    def __init__(self, by, reducer, conversion=None):
+    MODE_PARTIAL = "emit"
+    MODE_MERGE = "merge"
+    MODE_STATEFUL = "stateful"
+
+    def __init__(
+        self,
+        by,
+        reducer,
+        conversion=None,
+        mode=None,
+        parallel=None,
+        batch_size=10000,
+        max_groups=None,
+        spill_partitions=16,
+        presorted=False,
+    ):
         super().__init__()
+        if parallel is not None and (
+            not isinstance(parallel, int) or parallel < 1
+        ):
+            raise ValueError("parallel must be a positive integer")
+        if not isinstance(batch_size, int) or batch_size < 1:
+            raise ValueError("batch_size must be a positive integer")
+        self.parallel = parallel
+        self.batch_size = batch_size
+        if max_groups is not None:
+            if not isinstance(max_groups, int) or max_groups < 1:
+                raise ValueError("max_groups must be a positive integer")
+            if not by:
+                raise ValueError("max_groups is supported by group_by only")
+            if parallel is not None and parallel > 1:
+                raise ValueError("max_groups cannot be combined with parallel")
+        if not isinstance(spill_partitions, int) or spill_partitions < 1:
+            raise ValueError("spill_partitions must be a positive integer")
+        self.max_groups = max_groups
+        self.spill_partitions = spill_partitions
+        if presorted and (
+            max_groups is not None or (parallel is not None and parallel > 1)
+        ):
+            raise ValueError(
+                "presorted cannot be combined with max_groups and parallel"
+            )
+        self.presorted = presorted
         self.by = [self.ensure_conversion(by_) for by_ in by]
         self.reducer = self.ensure_conversion(reducer)
         self.contents = self.contents & ~self.ContentTypes.REDUCER
         self.number_of_input_uses = 1
         self.aggregate_mode = len(self.by) == 0
+        self.mode = mode
 
         if conversion:
             self.conversion = self.ensure_conversion(conversion)
         else:
             self.conversion = self.ensure_conversion(
-                ListComp(
+                (GeneratorComp if presorted else ListComp)(
                     GeneratorItem(
                         self.AGG_RESULT_ITEM,
                         self.SIGNATURE,
@@ -1349,87 +1901,281 @@ class Grouper(BaseConversion):
     sort = delegate_input_switching_method("sort", True)
     tap = delegate_input_switching_method("tap", True)
 
+    def check_not_presorted(self):
+        if self.presorted:
+            raise ValueError(
+                "presorted group by doesn't support partial states and "
+                "stateful aggregators"
+            )
+
+    def partial(self) -> "Grouper":
+        """Emit partial states of reducers instead of results.
+
+        The result is a tuple of reducer states for aggregations and a dict
+        of group keys to such tuples for group by. Partial states of
+        different batches of input are to be combined by ``merge_partials``.
+        """
+        self.check_not_presorted()
+        return Grouper(
+            self.by,
+            self.reducer,
+            self.conversion,
+            mode=self.MODE_PARTIAL,
+        )
+
+    def merge_partials(self) -> "Grouper":
+        """Merge an iterable of partial states into the final result.
+
+        Partial states are emitted by the ``partial`` counterpart of the
+        same aggregation. They are consumed, so are not to be reused.
+        """
+        self.check_not_presorted()
+        return Grouper(
+            self.by,
+            self.reducer,
+            self.conversion,
+            mode=self.MODE_MERGE,
+        )
+
+    def gen_parallel_code(self, code_input, ctx) -> str:
+        if self.contents & (
+            self.ContentTypes.ARG_USAGE | self.ContentTypes.LABEL_USAGE
+        ):
+            raise ValueError(
+                "parallel aggregations cannot use input args and labels"
+            )
+        try:
+            merge_partials = self.merge_partials().gen_converter()
+        except ValueError as e:
+            raise ValueError(
+                f"parallel aggregation requires mergeable reducers: {e}"
+            ) from e
+        return (
+            NaiveConversion(
+                ParallelAggregation(
+                    self.partial().gen_converter(),
+                    merge_partials,
+                    self.parallel,
+                    self.batch_size,
+                ),
+                name_prefix="parallel_aggregation",
+            )
+            .call(This)
+            .gen_code_and_update_ctx(code_input, ctx)
+        )
+
+    def gen_aggregator(self, **kwargs) -> "Aggregator":
+        """Compile an aggregator, which retains state between batches of rows.
+
+        Args:
+          kwargs: input args of the conversion, if any
+        """
+        self.check_not_presorted()
+        return Grouper(
+            self.by, self.reducer, self.conversion, mode=self.MODE_STATEFUL
+        ).gen_converter()(None, **kwargs)
+
     def _gen_code_and_update_ctx(self, code_input, ctx) -> str:
+        if (
+            self.parallel is not None
+            and self.parallel > 1
+            and self.mode is None
+        ):
+            return self.gen_parallel_code(code_input, ctx)
+
         ctx["defaultdict"] = defaultdict
         ctx["ListSortedOnceWrapper"] = ListSortedOnceWrapper
+        ctx["HyperLogLog"] = HyperLogLog
+        ctx["KLL"] = KLL
+        ctx["FrequentItems"] = FrequentItems
 
         suffix = self.gen_random_name("_", ctx)
         var_row = f"row{suffix}"
-        var_signature = f"signature{suffix}"
         var_signature_to_agg_data = f"signature_to_agg_data{suffix}"
         var_agg_data = f"agg_data{suffix}"
         var_agg_data_cls = f"AggData{suffix}"
 
-        function_ctx = self.as_function_ctx(ctx, optimize_naive=True)
-        function_ctx.add_arg("data_", This())
-
-        reduce_manager = ReduceManager(
-            var_row, var_agg_data, self.aggregate_mode
-        )
-        with function_ctx:
-            if "current_reduce_manager" not in ctx:
-                ctx["current_reduce_manager"] = [reduce_manager]
-            else:
-                ctx["current_reduce_manager"].append(reduce_manager)
-
-            try:
-                code_agg_result = self.reducer.gen_code_and_update_ctx(
-                    var_row, ctx
-                )
-            finally:
-                ctx["current_reduce_manager"].pop()
-                if not ctx["current_reduce_manager"]:
-                    del ctx["current_reduce_manager"]
-
-            by_is_single = len(self.by) == 1
-            code_signatures = []
-            for index, by_ in enumerate(self.by):
-                code_by = by_.gen_code_and_update_ctx(var_row, ctx)
-                code_signatures.append(code_by)
-                code_agg_result = self.replace_word(
-                    code_agg_result,
-                    code_by,
-                    (
-                        var_signature
-                        if by_is_single
-                        else f"{var_signature}[{index}]"
-                    ),
-                )
-
-            code_signature = (
-                code_signatures[0]
-                if by_is_single
-                else f"({', '.join(code_signatures)})"
+        runtime_counters = ctx[self.RUNTIME_COUNTERS]
+        counters = None
+        c_data = This()
+        merge_mode = self.mode == self.MODE_MERGE
+        stateful = self.mode == self.MODE_STATEFUL
+        if runtime_counters is not None and self.mode is None:
+            counters = (
+                runtime_counters.add_stage("aggregate", "rows_in")
+                if self.aggregate_mode
+                else runtime_counters.add_stage("group_by", "rows_in", "groups")
+            )
+            c_data = NaiveConversion(counters["rows_in"].count_iter).call(
+                c_data
             )
 
-            if var_row in code_agg_result:
-                raise ConversionException(
-                    "something other than group_by keys and reducers have been used",
-                    code_agg_result,
-                )
+        function_ctx = self.as_function_ctx(ctx, optimize_naive=True)
+        function_ctx.add_arg("data_", c_data)
 
-            with NamespaceCtx(
-                {
-                    self.SIGNATURE_NAME: var_signature,
-                    self.AGG_DATA_NAME: var_agg_data,
-                    self.AGG_RESULT_ITEM_NAME: code_agg_result,
-                },
+        with function_ctx:
+            spilling = self.max_groups is not None and self.mode is None
+            (
+                reduce_manager,
+                code_signature,
+                code_final_result,
+            ) = self.gen_reduce_code(
+                suffix,
+                var_row,
                 ctx,
+                code_items=(
+                    "items_"
+                    if spilling
+                    else ("iter_groups_()" if self.presorted else None)
+                ),
+            )
+            code_result = f"    return {code_final_result}"
+            if (
+                counters is not None
+                and not self.aggregate_mode
+                and self.max_groups is None
+                and not self.presorted
             ):
-                code_final_result = (
-                    self.conversion.gen_code_and_update_ctx(None, ctx)
-                    if self.aggregate_mode
-                    else self.conversion.gen_code_and_update_ctx(
-                        f"{var_signature_to_agg_data}.items()", ctx
-                    )
+                code_add_groups = NaiveConversion(
+                    counters["groups"].add
+                ).gen_code_and_update_ctx(None, ctx)
+                code_result = (
+                    f"    {code_add_groups}(len({var_signature_to_agg_data}))\n"
+                    f"{code_result}"
                 )
             agg_template_kwargs = {
                 "code_args": function_ctx.get_def_all_args_code(),
-                "code_result": f"    return {code_final_result}",
+                "code_result": code_result,
                 "var_row": var_row,
             }
 
-            if self.aggregate_mode:
+            if stateful and self.aggregate_mode:
+                ctx["Aggregator"] = Aggregator
+                converter_name = f"gen_aggregator{suffix}"
+                code_init_agg_vars = reduce_manager.gen_init_aggregate_vars()
+                code_nonlocal = (
+                    "nonlocal "
+                    + ", ".join(
+                        reduce_manager.fmt_agg_data_value(index)
+                        for index in reduce_manager.used_indexes
+                    )
+                    if reduce_manager.used_indexes
+                    else "pass"
+                )
+                code_update = Code()
+                code_update.add_line(f"for {var_row} in data_:", 1)
+                reduce_manager.add_group_by_code(
+                    code_update, reduce_manager.reduce_code
+                )
+                if len(code_update.lines_info) == 1:
+                    code_update.add_line("pass", 0)
+                grouper_code = STATEFUL_AGGREGATE_TEMPLATE.format(
+                    converter_name=converter_name,
+                    code_args=function_ctx.get_def_all_args_code(),
+                    code_init_agg_vars=code_init_agg_vars,
+                    code_nonlocal=code_nonlocal,
+                    code_update=code_update.to_string(base_indent_level=2),
+                    code_reset=code_init_agg_vars or "pass",
+                    code_final_result=code_final_result,
+                )
+            elif stateful:
+                ctx["Aggregator"] = Aggregator
+                converter_name = f"gen_aggregator{suffix}"
+                var_agg_data_cls = reduce_manager.gen_group_by_data_container(
+                    self, var_agg_data_cls, ctx
+                )
+                grouper_code = STATEFUL_GROUPER_TEMPLATE.format(
+                    converter_name=converter_name,
+                    code_args=function_ctx.get_def_all_args_code(),
+                    var_signature_to_agg_data=var_signature_to_agg_data,
+                    var_agg_data_cls=var_agg_data_cls,
+                    code_update=reduce_manager.gen_group_by_code(
+                        var_signature_to_agg_data=var_signature_to_agg_data,
+                        code_signature=code_signature,
+                    ).to_string(base_indent_level=2),
+                    code_final_result=code_final_result,
+                )
+            elif self.presorted:
+                converter_name = f"group_by_presorted{suffix}"
+                var_agg_data_cls = reduce_manager.gen_group_by_data_container(
+                    self, var_agg_data_cls, ctx
+                )
+                code_reduce = Code()
+                reduce_manager.add_group_by_code(
+                    code_reduce, reduce_manager.reduce_code
+                )
+                grouper_code = PRESORTED_GROUPER_TEMPLATE.format(
+                    converter_name=converter_name,
+                    var_signature=f"signature{suffix}",
+                    var_agg_data=var_agg_data,
+                    var_agg_data_cls=var_agg_data_cls,
+                    code_signature=code_signature,
+                    code_reduce=code_reduce.to_string(base_indent_level=3),
+                    **agg_template_kwargs,
+                )
+            elif spilling:
+                ctx["GroupsSpiller"] = GroupsSpiller
+                converter_name = f"group_by{suffix}"
+                var_signature = f"signature{suffix}"
+                var_agg_data_cls = reduce_manager.gen_group_by_data_container(
+                    self, var_agg_data_cls, ctx
+                )
+                code_states = reduce_manager.gen_signature_to_states_code(
+                    var_signature, var_signature_to_agg_data
+                )
+                code_group_by = reduce_manager.gen_group_by_code(
+                    var_signature_to_agg_data=var_signature_to_agg_data,
+                    code_signature=code_signature,
+                )
+                code_group_by.add_line(
+                    f"if len({var_signature_to_agg_data}) > {self.max_groups}:",
+                    1,
+                )
+                code_group_by.add_line(f"spiller_.spill({code_states})", 0)
+                code_group_by.add_line(
+                    f"{var_signature_to_agg_data}.clear()", -1
+                )
+                grouper_code = SPILL_GROUPER_TEMPLATE.format(
+                    converter_name=converter_name,
+                    var_signature_to_agg_data=var_signature_to_agg_data,
+                    var_agg_data_cls=var_agg_data_cls,
+                    var_signature=var_signature,
+                    var_agg_data=var_agg_data,
+                    spill_partitions=self.spill_partitions,
+                    code_merge=reduce_manager.gen_merge_code(
+                        "states_"
+                    ).to_string(base_indent_level=5),
+                    code_group_by=code_group_by.to_string(base_indent_level=1),
+                    code_states=code_states,
+                    **agg_template_kwargs,
+                )
+            elif merge_mode and self.aggregate_mode:
+                converter_name = f"merge_aggregate{suffix}"
+                grouper_code = MERGE_AGGREGATE_TEMPLATE.format(
+                    converter_name=converter_name,
+                    code_init_agg_vars=reduce_manager.gen_init_aggregate_vars(),
+                    code_merge=reduce_manager.gen_merge_code(
+                        "states_"
+                    ).to_string(base_indent_level=2),
+                    **agg_template_kwargs,
+                )
+            elif merge_mode:
+                converter_name = f"merge_group_by{suffix}"
+                var_agg_data_cls = reduce_manager.gen_group_by_data_container(
+                    self, var_agg_data_cls, ctx
+                )
+                grouper_code = MERGE_GROUPER_TEMPLATE.format(
+                    converter_name=converter_name,
+                    var_signature_to_agg_data=var_signature_to_agg_data,
+                    var_agg_data_cls=var_agg_data_cls,
+                    var_signature=f"signature{suffix}",
+                    var_agg_data=var_agg_data,
+                    code_merge=reduce_manager.gen_merge_code(
+                        "states_"
+                    ).to_string(base_indent_level=3),
+                    **agg_template_kwargs,
+                )
+            elif self.aggregate_mode:
                 converter_name = f"aggregate{suffix}"
                 grouper_code = AGGREGATE_TEMPLATE.format(
                     converter_name=converter_name,
@@ -1441,10 +2187,8 @@ class Grouper(BaseConversion):
                 )
             else:
                 converter_name = f"group_by{suffix}"
-                ctx[var_agg_data_cls] = (
-                    reduce_manager.gen_group_by_data_container(
-                        self, var_agg_data_cls, ctx
-                    )
+                var_agg_data_cls = reduce_manager.gen_group_by_data_container(
+                    self, var_agg_data_cls, ctx
                 )
                 grouper_code = GROUPER_TEMPLATE.format(
                     converter_name=converter_name,
@@ -1467,6 +2211,415 @@ class Grouper(BaseConversion):
         ).gen_code_and_update_ctx(code_input, ctx)
 
 
+    def gen_reduce_code(self, suffix, var_row, ctx, code_items=None):
+        """Generate reducers and the result code of the aggregation.
+
+        Rows are expected to be available as ``var_row``. It is to be called
+        within a function context. ``code_items`` overrides code of group
+        keys and agg data pairs to build group by results of.
+
+        Returns:
+          reduce manager, signature code and result code
+        """
+        var_signature = f"signature{suffix}"
+        var_signature_to_agg_data = f"signature_to_agg_data{suffix}"
+        var_agg_data = f"agg_data{suffix}"
+
+        reduce_manager = ReduceManager(
+            var_row,
+            var_agg_data,
+            self.aggregate_mode,
+            merge_mode=self.mode == self.MODE_MERGE
+            or self.max_groups is not None,
+            stateful=self.mode == self.MODE_STATEFUL,
+        )
+        if "current_reduce_manager" not in ctx:
+            ctx["current_reduce_manager"] = [reduce_manager]
+        else:
+            ctx["current_reduce_manager"].append(reduce_manager)
+
+        try:
+            code_agg_result = self.reducer.gen_code_and_update_ctx(
+                var_row, ctx
+            )
+        finally:
+            ctx["current_reduce_manager"].pop()
+            if not ctx["current_reduce_manager"]:
+                del ctx["current_reduce_manager"]
+
+        by_is_single = len(self.by) == 1
+        code_signatures = []
+        for index, by_ in enumerate(self.by):
+            code_by = by_.gen_code_and_update_ctx(var_row, ctx)
+            code_signatures.append(code_by)
+            code_agg_result = self.replace_word(
+                code_agg_result,
+                code_by,
+                (var_signature if by_is_single else f"{var_signature}[{index}]"),
+            )
+
+        code_signature = (
+            code_signatures[0]
+            if by_is_single
+            else f"({', '.join(code_signatures)})"
+        )
+
+        if var_row in code_agg_result:
+            raise ConversionException(
+                "something other than group_by keys and reducers have been used",
+                code_agg_result,
+            )
+
+        if self.mode == self.MODE_PARTIAL:
+            if self.aggregate_mode:
+                return (
+                    reduce_manager,
+                    code_signature,
+                    reduce_manager.gen_states_code(),
+                )
+            return (
+                reduce_manager,
+                code_signature,
+                reduce_manager.gen_signature_to_states_code(
+                    var_signature, var_signature_to_agg_data
+                ),
+            )
+
+        with NamespaceCtx(
+            {
+                self.SIGNATURE_NAME: var_signature,
+                self.AGG_DATA_NAME: var_agg_data,
+                self.AGG_RESULT_ITEM_NAME: code_agg_result,
+            },
+            ctx,
+        ):
+            if self.aggregate_mode:
+                code_final_result = self.conversion.gen_code_and_update_ctx(
+                    None, ctx
+                )
+            else:
+                # iterating groups is reported as "groups"
+                runtime_counters = ctx[self.RUNTIME_COUNTERS]
+                ctx[self.RUNTIME_COUNTERS] = None
+                try:
+                    code_final_result = self.conversion.gen_code_and_update_ctx(
+                        code_items or f"{var_signature_to_agg_data}.items()",
+                        ctx,
+                    )
+                finally:
+                    ctx[self.RUNTIME_COUNTERS] = runtime_counters
+        return reduce_manager, code_signature, code_final_result
+
+
+class GroupsSpiller:
+    """Spill partial states of groups to temporary files.
+
+    States are hash-partitioned by group keys, so each partition can be
+    merged on its own. Files are removed once partitions are iterated over
+    or the spiller is garbage collected.
+    """
+
+    def __init__(self, partitions_number):
+        self.partitions_number = partitions_number
+        self.spilled = False
+        self.temp_dir = None
+        self.files = None
+
+    def spill(self, signature_to_states):
+        if self.files is None:
+            self.temp_dir = (
+                tempfile.TemporaryDirectory(  # pylint: disable=consider-using-with
+                    prefix="convtools_spill_"
+                )
+            )
+            self.files = [
+                open(  # pylint: disable=consider-using-with
+                    os.path.join(self.temp_dir.name, str(index)), "w+b"
+                )
+                for index in range(self.partitions_number)
+            ]
+        self.spilled = True
+
+        partitions_number = self.partitions_number
+        partitions = [{} for _ in range(partitions_number)]
+        for signature, states in signature_to_states.items():
+            partitions[hash(signature) % partitions_number][signature] = states
+        for f, partition in zip(self.files, partitions):
+            if partition:
+                pickle.dump(partition, f, pickle.HIGHEST_PROTOCOL)
+
+    @staticmethod
+    def iter_partials(f):
+        f.seek(0)
+        try:
+            while True:
+                yield pickle.load(f)
+        except EOFError:
+            pass
+        finally:
+            f.close()
+
+    def iter_partitions(self):
+        try:
+            for f in self.files:
+                yield self.iter_partials(f)
+        finally:
+            self.close()
+
+    def close(self):
+        if self.files is not None:
+            for f in self.files:
+                f.close()
+            self.temp_dir.cleanup()
+            self.files = None
+
+
+class Aggregator:
+    """Stateful aggregation, which folds batches of rows as they come.
+
+    ``update(batch)`` folds rows into the retained state, ``snapshot()``
+    returns results of all rows folded so far without resetting the state
+    and ``reset()`` drops it. Lists and dicts of built-in reducers are
+    copied to snapshots, so they don't change on further updates.
+    """
+
+    __slots__ = ["update", "snapshot", "reset"]
+
+    def __init__(self, update, snapshot, reset):
+        self.update = update
+        self.snapshot = snapshot
+        self.reset = reset
+
+
+def run_partial_task(key, batch):
+    return ParallelAggregation.key_to_partial_converter[key](batch)
+
+
+class ParallelAggregation:
+    """Aggregate batches of input in worker processes and merge results.
+
+    Workers are forked on the first call and reused by further ones, so
+    they inherit the partial converter, which is registered for the
+    lifetime of the aggregation, while batches of rows are pickled. Where
+    forking is unavailable, batches are processed in the current process.
+    """
+
+    key_to_partial_converter: ClassVar[Dict[int, Callable]] = {}
+    # unique per aggregation, so workers of different ones don't mix them up
+    keys = count()
+
+    def __init__(
+        self, partial_converter, merge_converter, workers, batch_size
+    ):
+        self.partial_converter = partial_converter
+        self.merge_converter = merge_converter
+        self.workers = workers
+        self.batch_size = batch_size
+        self.pool = None
+        self.pool_lock = threading.Lock()
+        self.key = next(self.keys)
+        self.key_to_partial_converter[self.key] = partial_converter
+        weakref.finalize(
+            self, self.key_to_partial_converter.pop, self.key, None
+        )
+
+    def iter_batches(self, data):
+        it = iter(data)
+        batch_size = self.batch_size
+        while True:
+            batch = list(islice(it, batch_size))
+            if not batch:
+                return
+            yield batch
+
+    def get_pool(self):
+        with self.pool_lock:
+            if self.pool is None:
+                # keeps garbage collection of workers from touching (and so
+                # copying) memory pages inherited from the parent
+                if hasattr(gc, "freeze"):
+                    gc.freeze()
+                try:
+                    self.pool = multiprocessing.get_context("fork").Pool(
+                        self.workers
+                    )
+                finally:
+                    if hasattr(gc, "unfreeze"):
+                        gc.unfreeze()
+                # workers live as long as the aggregation does
+                weakref.finalize(self, self.pool.terminate)
+            return self.pool
+
+    def __call__(self, data):
+        if "fork" not in multiprocessing.get_all_start_methods():
+            warnings.warn(
+                "fork is unavailable, aggregating in the current process",
+                RuntimeWarning,
+                stacklevel=2,
+            )
+            return self.merge_converter(
+                map(self.partial_converter, self.iter_batches(data))
+            )
+
+        # ordered, so First / Last / Array results are preserved
+        return self.merge_converter(
+            self.get_pool().imap(
+                partial(run_partial_task, self.key), self.iter_batches(data)
+            )
+        )
+
+
+def unwrap_grouper(conversion):
+    """Return the grouper and conversions its result is piped to, if any.
+
+    Only inlined pipes without labels are unwrapped.
+    """
+    next_conversions = []
+    while (
+        type(conversion) is PipeConversion
+        and conversion.to_be_inlined
+        and conversion.label_input is None
+        and conversion.label_output is None
+    ):
+        next_conversions.append(conversion.where)
+        conversion = conversion.what
+    if (
+        type(conversion) is Grouper
+        and conversion.mode is None
+        and not (conversion.parallel and conversion.parallel > 1)
+        and conversion.max_groups is None
+        and not conversion.presorted
+    ):
+        next_conversions.reverse()
+        return conversion, next_conversions
+    return None, None
+
+
+FUSED_GROUPERS_TEMPLATE = """
+def {converter_name}({code_args}):
+{code_init}
+
+{code_rows}
+
+    return {code_result}
+"""
+
+
+def gen_fused_groupers_code(collection, grouper_indexes, code_input, ctx):
+    """Generate a collection, whose items are aggregations, in a single pass.
+
+    Aggregations of the same input (``Grouper`` items of the collection at
+    ``grouper_indexes``) share a single loop over it, each one processing
+    rows by its own reducers. Other items are evaluated as is.
+    """
+    ctx["defaultdict"] = defaultdict
+    ctx["ListSortedOnceWrapper"] = ListSortedOnceWrapper
+    ctx["HyperLogLog"] = HyperLogLog
+    ctx["KLL"] = KLL
+    ctx["FrequentItems"] = FrequentItems
+
+    suffix = collection.gen_random_name("_", ctx)
+    var_row = f"row{suffix}"
+    converter_name = f"aggregate_fused{suffix}"
+    items = (
+        collection.conversions
+        if collection.pairs is None
+        else [value for _, value in collection.pairs]
+    )
+
+    function_ctx = collection.as_function_ctx(ctx, optimize_naive=True)
+    function_ctx.add_arg("data_", This())
+    var_init_checksum = "checksum_"
+    with function_ctx:
+        code_init = Code()
+        # rows until all aggregate values are initialized and afterwards
+        code_rows = Code()
+        code_rows_stage2 = Code()
+        checksum = 0
+        index_to_code = {}
+        for index in grouper_indexes:
+            grouper, next_conversions = unwrap_grouper(items[index])
+            grouper_suffix = grouper.gen_random_name("_", ctx)
+            (
+                reduce_manager,
+                code_signature,
+                code_item,
+            ) = grouper.gen_reduce_code(grouper_suffix, var_row, ctx)
+            for next_conversion in next_conversions:
+                code_item = next_conversion.gen_code_and_update_ctx(
+                    code_item, ctx
+                )
+            index_to_code[index] = code_item
+
+            if grouper.aggregate_mode:
+                code_init_agg_vars = reduce_manager.gen_init_aggregate_vars()
+                if code_init_agg_vars:
+                    code_init.add_line(code_init_agg_vars, 0)
+                checksum += reduce_manager.add_group_by_code(
+                    code_rows,
+                    reduce_manager.reduce_code,
+                    var_init_checksum=var_init_checksum,
+                )
+                reduce_manager.add_aggregate_stage2_code(
+                    code_rows_stage2, reduce_manager.reduce_code
+                )
+            else:
+                var_signature_to_agg_data = (
+                    f"signature_to_agg_data{grouper_suffix}"
+                )
+                var_agg_data_cls = reduce_manager.gen_group_by_data_container(
+                    grouper, f"AggData{grouper_suffix}", ctx
+                )
+                code_init.add_line(
+                    f"{var_signature_to_agg_data} = "
+                    f"defaultdict({var_agg_data_cls})",
+                    0,
+                )
+                reduce_manager.add_row_code(
+                    code_rows, var_signature_to_agg_data, code_signature
+                )
+                reduce_manager.add_row_code(
+                    code_rows_stage2, var_signature_to_agg_data, code_signature
+                )
+
+        code = Code()
+        if checksum:
+            code.add_line(f"{var_init_checksum} = 0", 0)
+            code.add_line("it_ = iter(data_)", 0)
+            code.add_line(f"for {var_row} in it_:", 1)
+            code.add_code(code_rows)
+            code.add_line(f"if {var_init_checksum} == {checksum}:", 1)
+            code.add_line("break", -2)
+            if code_rows_stage2.lines_info:
+                code.add_line(f"for {var_row} in it_:", 1)
+                code.add_code(code_rows_stage2)
+        else:
+            code.add_line(f"for {var_row} in data_:", 1)
+            code.add_code(code_rows)
+            if not code_rows.lines_info:
+                code.add_line("pass", 0)
+
+        code_result = collection.gen_collection_from_items_code(
+            collection.gen_joined_items_code("data_", ctx, index_to_code),
+            "data_",
+            ctx,
+        )
+        conversion = function_ctx.gen_conversion(
+            converter_name,
+            FUSED_GROUPERS_TEMPLATE.format(
+                converter_name=converter_name,
+                code_args=function_ctx.get_def_all_args_code(),
+                code_init=code_init.to_string(base_indent_level=1),
+                var_row=var_row,
+                code_rows=code.to_string(base_indent_level=1),
+                code_result=code_result,
+            ),
+        )
+    return function_ctx.call_with_all_args(conversion).gen_code_and_update_ctx(
+        code_input, ctx
+    )
+
+
 def Aggregate(  # pylint:disable=invalid-name
     *args, **kwargs
 ) -> BaseConversion:
@@ -1487,6 +2640,7 @@ class Reduce(BaseReducer):
         default: Union[_None, Callable, Any] = _none,
         unconditional_init: bool = False,
         where=None,
+        merge: Union[None, Callable, InlineExpr] = None,
     ):
         """Init self.
 
@@ -1507,12 +2661,19 @@ class Reduce(BaseReducer):
           unconditional_init: tells whether the first call initializes the
             aggregation value OR there is a condition for that
           where: condition conversion to pre-filter values to be reduced.
+          merge: defines the function/expression, which merges two partial
+            states (aggregation values) into one. It is required to merge
+            partial states (see ``Grouper.merge_partials``). Every partial
+            state includes initial, so merged results are correct only if
+            initial is neutral to merge (e.g. 0 for addition) or merge
+            absorbs its repetitions (e.g. max).
         """
         super().__init__(
             *expressions, initial=initial, default=default, where=where
         )
 
         self.to_call_with_2_args = self.ensure_conversion(to_call_with_2_args)
+        self.merge = None if merge is None else self.ensure_conversion(merge)
         if unconditional_init:
             warnings.warn(
                 "unconditional_init is no longer needed",
@@ -1532,3 +2693,12 @@ class Reduce(BaseReducer):
             *self.expressions,
         ).gen_code_and_update_ctx("%(row)s", ctx)
         return (f"%(result)s = {_}",)
+
+    def get_merge_lines(self, ctx):
+        # initial can't be validated, see the requirements in the docstring
+        if self.merge is None:
+            raise ValueError("Reduce requires merge to merge partial states")
+        _ = self.merge.call_like(
+            EscapedString("%(result)s"), EscapedString("%(other)s")
+        ).gen_code_and_update_ctx(None, ctx)
+        return (f"%(result)s = {_}",)
@@ -1,5 +1,6 @@
 """Base and basic conversions are defined here."""
 
+import operator
 import re
 import string
 import sys
@@ -8,7 +9,9 @@ from datetime import datetime
 from decimal import Decimal
 from itertools import chain
 from keyword import iskeyword
+from math import isfinite
 from random import Random
+from threading import Lock
 from typing import (
     TYPE_CHECKING,
     Any,
@@ -26,17 +29,23 @@ from typing import (
     Union,
 )
 
-from ._heuristics import Weights
+from ._heuristics import WEIGHT_NAMES, Weights
+from ._source_maps import find_call_site, source_maps
 from ._utils import (
     BaseCtx,
     BaseOptions,
     Code,
+    CodegenProfiler,
     CodeStorage,
     LazyModule,
+    LRUCache,
+    RuntimeCounters,
     _None,
     _none,
+    bytecode_cache,
     get_builtins_dict,
     iter_windows,
+    profile_phase,
 )
 
 
@@ -54,7 +63,20 @@ except ImportError:
 
 
 class CodeGenerationOptions(BaseOptions):
-    pass
+    """Code generation options (+ see default values below).
+
+    * ``common_subexpressions = True`` - hoist lookups repeated within a
+      comprehension row into variables
+    * ``fuse_pipelines = True`` - generate chains of ``iter`` / ``filter``
+      as a single comprehension instead of nested generators
+    * ``fuse_aggregations = True`` - run aggregations, which are items of the
+      same collection, in a single pass over the input
+
+    """
+
+    common_subexpressions = True
+    fuse_pipelines = True
+    fuse_aggregations = True
 
 
 class CodeGenerationOptionsCtx(BaseCtx):
@@ -65,10 +87,14 @@ class ConverterOptions(BaseOptions):
     """Converter options (+ see default values below).
 
     * ``debug = False`` - same as ``.gen_converter(debug=...)``
+    * ``cache = False`` - same as ``.gen_converter(cache=...)``
+    * ``lazy = False`` - same as ``.gen_converter(lazy=...)``
 
     """
 
     debug = False
+    cache = False
+    lazy = False
 
 
 class ConverterOptionsCtx(BaseCtx):
@@ -84,6 +110,133 @@ class ConverterOptionsCtx(BaseCtx):
     options_cls = ConverterOptions
 
 
+#: process-wide cache of compiled converters, keyed by structure of
+#: conversions and gen_converter params (see ``gen_converter(cache=True)``)
+converters_cache = LRUCache(maxsize=512)
+
+
+def gen_codegen_settings_key():
+    """Build a key of code generation options and weights of heuristics.
+
+    They affect generated code, so converters are cached per their values.
+    """
+    # pylint: disable=protected-access
+    return (
+        tuple(
+            CodeGenerationOptionsCtx.get_option_value(option_name)
+            for option_name in CodeGenerationOptions._option_attrs
+        ),
+        tuple(getattr(Weights, name) for name in WEIGHT_NAMES),
+    )
+
+
+_KEY_BY_VALUE_TYPES = {type(None), bool, int, str, bytes, complex}
+_KEY_BY_REPR_TYPES = {float, Decimal}
+
+
+def gen_naive_value_key(value, memo):
+    """Build a key of a value exposed to generated code as is.
+
+    Generated code references such values directly, so mutable ones are
+    compared by identity.
+    """
+    value_type = type(value)
+    if value_type in _KEY_BY_VALUE_TYPES:
+        return (value_type, value)
+    if value_type in _KEY_BY_REPR_TYPES:
+        return (value_type, repr(value))
+    if value_type is tuple:
+        return (
+            value_type,
+            tuple(gen_naive_value_key(item, memo) for item in value),
+        )
+    if value_type is frozenset:
+        return (
+            value_type,
+            frozenset(gen_naive_value_key(item, memo) for item in value),
+        )
+    if isinstance(value, BaseConversion):
+        return gen_structural_key(value, memo)
+    try:
+        hash(value)
+    except TypeError:
+        return ("id", id(value))
+    return (value_type, value)
+
+
+def gen_structural_key(obj, memo=None):
+    """Build a hashable key, which is equal for structurally equal objects.
+
+    Conversions and other convtools internals are compared attribute by
+    attribute, simple immutable values are compared by value and the rest is
+    compared by identity (e.g. functions and mutable objects passed to
+    ``c.naive``).
+    """
+    if memo is None:
+        memo = {}
+
+    obj_type = type(obj)
+    if obj_type in _KEY_BY_VALUE_TYPES:
+        return (obj_type, obj)
+    if obj_type in _KEY_BY_REPR_TYPES:
+        return (obj_type, repr(obj))
+    if obj_type is NaiveConversion:
+        return (
+            obj_type,
+            obj.name_prefix,
+            gen_naive_value_key(obj.value, memo),
+        )
+    if obj_type is tuple or obj_type is list:
+        return (
+            obj_type,
+            tuple(gen_structural_key(item, memo) for item in obj),
+        )
+    if obj_type is dict:
+        return (
+            obj_type,
+            tuple(
+                (gen_structural_key(k, memo), gen_structural_key(v, memo))
+                for k, v in obj.items()
+            ),
+        )
+    if obj_type is set or obj_type is frozenset:
+        return (
+            obj_type,
+            frozenset(gen_structural_key(item, memo) for item in obj),
+        )
+
+    if isinstance(obj, BaseConversion) or obj_type.__module__.startswith(
+        "convtools."
+    ):
+        obj_id = id(obj)
+        if obj_id in memo:
+            return memo[obj_id]
+        memo[obj_id] = ("cycle", obj_id)
+
+        attrs = dict(getattr(obj, "__dict__", ()))
+        for cls in obj_type.__mro__:
+            for name in getattr(cls, "__slots__", ()):
+                if name not in attrs and hasattr(obj, name):
+                    attrs[name] = getattr(obj, name)
+        attrs.pop("_depends_on", None)
+        attrs.pop("_call_site", None)
+
+        key = memo[obj_id] = (
+            obj_type,
+            tuple(
+                (name, gen_structural_key(value, memo))
+                for name, value in sorted(attrs.items())
+            ),
+        )
+        return key
+
+    try:
+        hash(obj)
+    except TypeError:
+        return ("id", id(obj))
+    return (obj_type, obj)
+
+
 CONVERTER_TEMPLATE = """
 def {converter_name}({code_signature}):
 {code}
@@ -152,10 +305,6 @@ class ConversionException(Exception):
 CT = TypeVar("CT", bound="BaseConversion")
 
 
-_random = Random(1)
-choice = _random.choice
-
-
 class BaseConversion(Generic[CT]):
     """Base class of every conversion.
 
@@ -204,8 +353,13 @@ class BaseConversion(Generic[CT]):
     function_call_threshold = Weights.FUNCTION_CALL * 1.33
 
     base_type_to_cast: "Union[_None, Type]" = _none
+    # "filename:lineno" of user code, which created the conversion; recorded
+    # only while source maps are enabled
+    _call_site: "Optional[str]" = None
 
     def __init__(self):
+        if source_maps.enabled:
+            self._call_site = find_call_site()
         self._depends_on = {}
         self.contents = self.self_content_type
         self.total_weight = self.weight
@@ -217,6 +371,17 @@ class BaseConversion(Generic[CT]):
     def __iter__(self):
         raise TypeError("'BaseConversion' is not iterable")
 
+    def structural_key(self):
+        """Hashable key, which is equal for structurally equal conversions.
+
+        ``==`` is overloaded to build ``Eq`` conversions, so use this or
+        ``structurally_equals`` to compare conversion trees.
+        """
+        return gen_structural_key(self)
+
+    def structurally_equals(self, other: "BaseConversion") -> bool:
+        return self.structural_key() == gen_structural_key(other)
+
     def add_hint(self, hint: int):
         self.output_hints |= hint
         return self
@@ -227,6 +392,14 @@ class BaseConversion(Generic[CT]):
     def is_simple_for_n_uses(self, n):
         return self.total_weight * (n - 1) < self.function_call_threshold
 
+    def get_constant(self) -> "Any":
+        """Return the value if it is known before code generation.
+
+        Returns ``_none`` if the result depends on the input or on runtime
+        state.
+        """
+        return _none
+
     def check_dependency(self, b):
         if (
             b.contents & 1 and self.self_content_type & 1
@@ -270,12 +443,18 @@ class BaseConversion(Generic[CT]):
         However you should not override this method
         directly, please implement the `_gen_code_and_update_ctx` one
         """
+        if CodegenProfiler.active_count:
+            with profile_phase("gen_code", type(self).__name__):
+                return self._gen_code_and_update_ctx(code_input, ctx)
         return self._gen_code_and_update_ctx(code_input, ctx)
 
     def _gen_code_and_update_ctx(self, code_input, ctx) -> str:
         raise NotImplementedError
 
     def to_code(self, code_input, ctx) -> "Optional[Code]":
+        if CodegenProfiler.active_count:
+            with profile_phase("gen_code", type(self).__name__):
+                return self._to_code(code_input, ctx)
         return self._to_code(code_input, ctx)
 
     def _to_code(
@@ -288,8 +467,18 @@ class BaseConversion(Generic[CT]):
     PREFIXED_HASH_TO_NAME = "_prefixed_hash_to_name"
     GENERATED_NAMES = "_generated_names"
 
+    NAMES_RANDOM = "_names_random"
+
     def gen_random_name(self, prefix, ctx) -> str:
+        if CodegenProfiler.active_count:
+            with profile_phase("gen_random_name"):
+                return self._gen_random_name(prefix, ctx)
+        return self._gen_random_name(prefix, ctx)
+
+    def _gen_random_name(self, prefix, ctx) -> str:
         generated_names = ctx[self.GENERATED_NAMES]
+        # seeded per ctx, so same conversions result in same code
+        choice = ctx[self.NAMES_RANDOM].choice
         name = prefix if prefix.startswith("_") else f"_{prefix}"
         for _ in range(10):
             if _ or iskeyword(name):
@@ -309,6 +498,12 @@ class BaseConversion(Generic[CT]):
 
         This also ensures that items with same items_to_hash get same names.
         """
+        if CodegenProfiler.active_count:
+            with profile_phase("gen_name"):
+                return self._gen_name(prefix, ctx, item_to_hash)
+        return self._gen_name(prefix, ctx, item_to_hash)
+
+    def _gen_name(self, prefix, ctx, item_to_hash) -> str:
         prefixed_hash_to_name = ctx[self.PREFIXED_HASH_TO_NAME]
         prefixed_hash = (prefix, item_to_hash)
         try:
@@ -325,15 +520,39 @@ class BaseConversion(Generic[CT]):
         prefixed_hash_to_name[prefixed_hash] = name
         return name
 
-    _word_pattern_format = r"((?<=\W)|^){}((?=\W)|$)"
+    @staticmethod
+    def replace_word(where: str, word: str, with_what: str) -> str:
+        """Replace occurrences of word, surrounded by non-word chars.
 
-    @classmethod
-    def replace_word(cls, where: str, word: str, with_what: str) -> str:
-        return re.sub(
-            cls._word_pattern_format.format(re.escape(word)),
-            with_what,
-            where,
-        )
+        Scans with str.find instead of regex: words are mostly unique
+        generated names, so compiled patterns would just overflow re cache.
+        """
+        if CodegenProfiler.active_count:
+            with profile_phase("replace_word"):
+                return BaseConversion._replace_word(where, word, with_what)
+        return BaseConversion._replace_word(where, word, with_what)
+
+    @staticmethod
+    def _replace_word(where: str, word: str, with_what: str) -> str:
+        parts = []
+        start = 0
+        word_length = len(word)
+        index = where.find(word)
+        while index != -1:
+            end = index + word_length
+            if (index == 0 or not _is_word_char(where[index - 1])) and (
+                end == len(where) or not _is_word_char(where[end])
+            ):
+                parts.append(where[start:index])
+                parts.append(with_what)
+                start = end
+                index = where.find(word, end)
+            else:
+                index = where.find(word, index + 1)
+        if not parts:
+            return where
+        parts.append(where[start:])
+        return "".join(parts)
 
     def as_function_ctx(
         self,
@@ -438,9 +657,11 @@ class BaseConversion(Generic[CT]):
         ) or ConverterOptionsCtx.get_option_value("debug")
         if is_debug and black:
             try:
-                code = black.format_str(
-                    code, mode=black.FileMode(line_length=160)  # type: ignore
-                )
+                with profile_phase("black"):
+                    code = black.format_str(
+                        code,
+                        mode=black.FileMode(line_length=160),  # type: ignore
+                    )
             except black.InvalidInput:
                 pass
 
@@ -452,16 +673,62 @@ class BaseConversion(Generic[CT]):
             if is_debug:
                 sys.stdout.write(code)
                 sys.stdout.write("\n")
-            code_obj = compile(code, code_piece.abs_path, "exec", optimize=2)
-            exec(code_obj, ctx)  # pylint:disable=exec-used
+            pending_sources = ctx[self.PENDING_SOURCES]
+            if pending_sources is not None:
+                pending_sources.append((converter_name, code_piece, self))
+                return converter_name
+            with profile_phase("compile"):
+                code_obj = bytecode_cache.compile(
+                    code, code_piece.abs_path, 2
+                )
+            with profile_phase("exec"):
+                exec(code_obj, ctx)  # pylint:disable=exec-used
             ctx[converter_name].conv_name = converter_name
+            if source_maps.enabled:
+                source_maps.register(code_piece.abs_path, code, self)
             return converter_name
         else:
             return code_piece.converter_name
 
+    @classmethod
+    def _compile_pending_sources(cls, ctx):
+        """Compile code pieces deferred by ``compile_converter`` at once."""
+        pending_sources = ctx[cls.PENDING_SOURCES]
+        if not pending_sources:
+            return
+        code_piece = ctx["__convtools__code_storage"].add_batch(
+            [code_piece for _, code_piece, _ in pending_sources]
+        )
+        with profile_phase("compile"):
+            code_obj = bytecode_cache.compile(
+                "".join(code_piece.code_parts), code_piece.abs_path, 2
+            )
+        with profile_phase("exec"):
+            exec(code_obj, ctx)  # pylint:disable=exec-used
+        for converter_name, _, _ in pending_sources:
+            ctx[converter_name].conv_name = converter_name
+        if source_maps.enabled:
+            line_offset = 0
+            for _, pending_piece, conversion in pending_sources:
+                code = "".join(pending_piece.code_parts)
+                source_maps.register(
+                    code_piece.abs_path, code, conversion, line_offset
+                )
+                # add_batch joins pieces with "\n"
+                line_offset += code.count("\n") + 1
+        pending_sources.clear()
+
     NAMESPACES = "_name_to_code_input"
     CONVERTERS_CACHE = "_converters_cache"
     NAIVE_TO_WARM_UP = "_naive_to_warm_up"
+    # list of (name, code piece, conversion) to be compiled at once;
+    # None - compile right away
+    PENDING_SOURCES = "_pending_sources"
+    # RuntimeCounters of an instrumented converter or None
+    RUNTIME_COUNTERS = "_runtime_counters"
+    # lookup code to variable name of hoisted common subexpressions, which
+    # are available at the moment; None - nothing is hoisted
+    CSE_SUBSTITUTIONS = "_cse_substitutions"
 
     exceptions_to_dump_sources = (Exception, KeyboardInterrupt)
 
@@ -475,9 +742,13 @@ class BaseConversion(Generic[CT]):
             "__none__": cls._none,
             cls.CONVERTERS_CACHE: {},
             cls.GENERATED_NAMES: set(),
+            cls.NAMES_RANDOM: Random(1),
             cls.NAMESPACES: [{}],
             cls.PREFIXED_HASH_TO_NAME: {},
             cls.NAIVE_TO_WARM_UP: None,
+            cls.PENDING_SOURCES: None,
+            cls.RUNTIME_COUNTERS: None,
+            cls.CSE_SUBSTITUTIONS: None,
             "__convtools__code_storage": CodeStorage(),
             "__exceptions_to_dump_sources": cls.exceptions_to_dump_sources,
             # SetUpCumulative.__cumulative_names__
@@ -491,6 +762,9 @@ class BaseConversion(Generic[CT]):
         signature=None,
         debug=None,
         converter_name="converter",
+        cache=None,
+        lazy=None,
+        instrument=False,
         _inner=False,
     ):
         """Compile a function which implements the conversion.
@@ -498,6 +772,15 @@ class BaseConversion(Generic[CT]):
         Args:
           debug (bool): If `True`, prints the generated code (formats with
             black if available). By default: None
+          cache (bool): If `True`, reuses a converter previously compiled for
+            a structurally equal conversion with the same params (see
+            ``c.converters_cache``). Defaults to ``ConverterOptions.cache``.
+          lazy (bool): If `True`, returns a stub which compiles the converter
+            on the first call and then turns into it. Defaults to
+            ``ConverterOptions.lazy``.
+          instrument (bool): If `True`, generated code counts rows passing
+            through comprehensions, group_by/aggregate and join conversions;
+            see ``converter.counters.snapshot()``. Disables the cache.
           signature (str): Defines the signature of the function to be
             compiled.  `data_` argument is what going to be used as the input.
             e.g. ``signature="self, dt, data_, **kwargs"``
@@ -510,6 +793,19 @@ class BaseConversion(Generic[CT]):
         Returns:
           The compiled function
         """
+        if lazy is None:
+            lazy = ConverterOptionsCtx.get_option_value("lazy")
+        if lazy and not _inner:
+            return self._gen_lazy_converter(
+                method=method,
+                class_method=class_method,
+                signature=signature,
+                debug=debug,
+                converter_name=converter_name,
+                cache=cache,
+                instrument=instrument,
+            )
+
         if (
             (debug or (self.contents & self.ContentTypes.BREAKPOINT))
             and not _inner
@@ -523,14 +819,160 @@ class BaseConversion(Generic[CT]):
                     signature=signature,
                     debug=True,
                     converter_name=converter_name,
+                    cache=False,
+                    lazy=False,
+                    instrument=instrument,
                     _inner=True,
                 )
+
+        if cache is None:
+            cache = ConverterOptionsCtx.get_option_value("cache")
+        cache_key = None
+        if (
+            cache
+            and not debug
+            and not instrument
+            and not _inner
+            and not ConverterOptionsCtx.get_option_value("debug")
+        ):
+            with profile_phase("cache_lookup"):
+                cache_key = (
+                    self.structural_key(),
+                    method,
+                    class_method,
+                    signature,
+                    converter_name,
+                    gen_codegen_settings_key(),
+                )
+                try:
+                    cached = converters_cache.get(cache_key)
+                except (TypeError, ValueError):
+                    cached = cache_key = None
+            if cached is not None:
+                return classmethod(cached[0]) if class_method else cached[0]
+
+        with profile_phase("gen_converter", type(self).__name__):
+            ctx = self._init_ctx(debug=debug)
+            if instrument:
+                runtime_counters = ctx[self.RUNTIME_COUNTERS] = (
+                    RuntimeCounters()
+                )
+            converter = self.gen_converter_in_ctx(
+                ctx,
+                method=method,
+                class_method=class_method,
+                signature=signature,
+                converter_name=converter_name,
+            )
+            self._cleanup_ctx(ctx)
+
+        if debug:
+            ctx["__convtools__code_storage"].dump_sources()
+
+        if instrument:
+            converter.counters = runtime_counters
+
+        if cache_key is not None:
+            # the conversion is stored too to keep objects compared by
+            # identity alive, so their ids are not reused
+            converters_cache.set(cache_key, (converter, self))
+
+        if class_method:
+            return classmethod(converter)
+
+        return converter
+
+    _lazy_stub_code = compile(
+        "def converter(*args, **kwargs):\n"
+        "    return __convtools__compile_lazy()(*args, **kwargs)\n",
+        "<convtools lazy converter>",
+        "exec",
+    )
+
+    def _gen_lazy_converter(self, class_method=False, **kwargs):
+        """Return a stub, which compiles the converter on the first call.
+
+        Once compiled, the stub gets globals, defaults and the code of the
+        real converter, so further calls have no overhead.
+        """
+        lock = Lock()
+        converter = None
+        stub_globals: "Dict[str, Any]" = {}
+
+        def compile_lazy():
+            nonlocal converter
+            if converter is not None:
+                return converter
+            with lock:
+                if converter is None:
+                    compiled = self.gen_converter(
+                        class_method=class_method, lazy=False, **kwargs
+                    )
+                    if class_method:
+                        compiled = compiled.__func__
+                    if not compiled.__code__.co_freevars:
+                        stub_globals.update(compiled.__globals__)
+                        stub.__defaults__ = compiled.__defaults__
+                        stub.__kwdefaults__ = compiled.__kwdefaults__
+                        stub.__name__ = compiled.__name__
+                        stub.__qualname__ = compiled.__qualname__
+                        stub.__dict__.update(compiled.__dict__)
+                        # the code goes last: concurrent calls either hit
+                        # the stub code or the fully prepared converter
+                        stub.__code__ = compiled.__code__
+                    converter = compiled
+            return converter
+
+        stub_globals["__convtools__compile_lazy"] = compile_lazy
+        exec(self._lazy_stub_code, stub_globals)  # pylint:disable=exec-used
+        stub = stub_globals.pop("converter")
+        if class_method:
+            return classmethod(stub)
+        return stub
+
+    def gen_converter_in_ctx(
+        self,
+        ctx,
+        method=False,
+        class_method=False,
+        signature=None,
+        converter_name="converter",
+    ):
+        """Generate converter code and compile it within the passed ctx.
+
+        Multiple converters can be generated within the same ctx (see
+        ``_init_ctx``), so they share helper functions and globals. Call
+        ``_cleanup_ctx`` once done.
+        """
+        converter_name = self.gen_converter_name_in_ctx(
+            ctx,
+            method=method,
+            class_method=class_method,
+            signature=signature,
+            converter_name=converter_name,
+        )
+        if converter_name not in ctx:
+            self._compile_pending_sources(ctx)
+        return ctx[converter_name]
+
+    def gen_converter_name_in_ctx(
+        self,
+        ctx,
+        method=False,
+        class_method=False,
+        signature=None,
+        converter_name="converter",
+    ):
+        """Same as ``gen_converter_in_ctx``, but returns the name only.
+
+        So compilation of sources, deferred within the ctx (see
+        ``PENDING_SOURCES``), is not forced.
+        """
         # signature should contain "data_" argument
         initial_code_input = "data_"
         # self.ContentTypes.NEW_LABEL | self.ContentTypes.LABEL_USAGE
         has_labels = self.contents & 20
         has_none = self.contents & 128  # self.ContentTypes.NONE_USAGE
-        ctx = self._init_ctx(debug=debug)
 
         args_to_skip = (
             "self",
@@ -601,23 +1043,21 @@ class BaseConversion(Generic[CT]):
             code.add_line("__convtools__code_storage.dump_sources()", 0)
             code.add_line("raise", -1)
 
-            converter = function_ctx.gen_function(
+            return function_ctx.compile_n_return_name(
                 converter_name, code.to_string(base_indent_level=0)
             )
 
-        del ctx[self.CONVERTERS_CACHE]
-        del ctx[self.GENERATED_NAMES]
-        del ctx[self.NAMESPACES]
-        del ctx[self.PREFIXED_HASH_TO_NAME]
-        del ctx[self.NAIVE_TO_WARM_UP]
-
-        if debug:
-            ctx["__convtools__code_storage"].dump_sources()
-
-        if class_method:
-            return classmethod(converter)
-
-        return converter
+    @classmethod
+    def _cleanup_ctx(cls, ctx):
+        del ctx[cls.CONVERTERS_CACHE]
+        del ctx[cls.GENERATED_NAMES]
+        del ctx[cls.NAMES_RANDOM]
+        del ctx[cls.NAMESPACES]
+        del ctx[cls.PREFIXED_HASH_TO_NAME]
+        del ctx[cls.NAIVE_TO_WARM_UP]
+        del ctx[cls.PENDING_SOURCES]
+        del ctx[cls.RUNTIME_COUNTERS]
+        del ctx[cls.CSE_SUBSTITUTIONS]
 
     def execute(self, *args, debug=None, **kwargs) -> Any:
         """Shortcut for `gen_converter()` and running it."""
@@ -1365,6 +1805,76 @@ class BaseConversion(Generic[CT]):
         return self
 
 
+def gen_converters(
+    conversions: "Mapping[str, Any]",
+    method=False,
+    class_method=False,
+    signature=None,
+    debug=None,
+) -> "Dict[str, Any]":
+    """Compile multiple converters at once.
+
+    Converters are generated within a single ctx, so helper functions are
+    shared, and their sources are compiled as a single module with one
+    ``compile`` + ``exec`` call.
+
+    Args:
+      conversions: converter name to conversion mapping
+      method, class_method, signature, debug: see ``gen_converter``
+
+    Returns:
+      dict: converter name to compiled function mapping
+    """
+    conversions = {
+        converter_name: ensure_conversion(conversion)
+        for converter_name, conversion in conversions.items()
+    }
+    if (
+        debug
+        or any(
+            conversion.contents & BaseConversion.ContentTypes.BREAKPOINT
+            for conversion in conversions.values()
+        )
+    ) and not ConverterOptionsCtx.get_option_value("debug"):
+        with ConverterOptionsCtx() as options:
+            options.debug = True
+            return gen_converters(
+                conversions,
+                method=method,
+                class_method=class_method,
+                signature=signature,
+                debug=True,
+            )
+
+    with profile_phase("gen_converters"):
+        ctx = BaseConversion._init_ctx(debug=debug)
+        ctx[BaseConversion.PENDING_SOURCES] = []
+        name_to_generated_name = {
+            converter_name: conversion.gen_converter_name_in_ctx(
+                ctx,
+                method=method,
+                class_method=class_method,
+                signature=signature,
+                converter_name=converter_name,
+            )
+            for converter_name, conversion in conversions.items()
+        }
+        BaseConversion._compile_pending_sources(ctx)
+        BaseConversion._cleanup_ctx(ctx)
+
+    if debug:
+        ctx["__convtools__code_storage"].dump_sources()
+
+    return {
+        converter_name: (
+            classmethod(ctx[generated_name])
+            if class_method
+            else ctx[generated_name]
+        )
+        for converter_name, generated_name in name_to_generated_name.items()
+    }
+
+
 class BaseMutation(BaseConversion):
     used_in_narrow_context = True
     weight = Weights.FUNCTION_CALL
@@ -1401,6 +1911,10 @@ _pattern_illegal_leading_chars = re.compile("^[^a-zA-Z_]+")
 _pattern_word = re.compile(r"(\w+)")
 
 
+def _is_word_char(char):
+    return char == "_" or char.isalnum()
+
+
 def var_name_from_string(s):
     # Remove invalid characters
     s = _pattern_illegal_chars.sub("", s)
@@ -1425,7 +1939,6 @@ class NaiveConversion(BaseConversion):
         & ~BaseConversion.ContentTypes.FUNCTION_OF_INPUT
     )
 
-    types_to_repr = {type(None), bool, int}
     weight = Weights.STEP
 
     def __init__(self, value: Any, name_prefix="v"):
@@ -1454,19 +1967,27 @@ class NaiveConversion(BaseConversion):
                 if f_name:
                     self.name_prefix = f_name
         else:
-            value_type = type(value)
-            if (
-                value_type in self.types_to_repr
-                or value_type is str
-                and len(value) < 128
-                and "%" not in value
-                and "{" not in value
-            ):
-                self.code_str = repr(value)
+            self.code_str = self.gen_literal_code(value)
 
         if not self.code_str:
             self.total_weight = Weights.DICT_LOOKUP
 
+    @staticmethod
+    def gen_literal_code(value) -> "Optional[str]":
+        """Return code of a literal to be inlined instead of the value."""
+        value_type = type(value)
+        if value is None or value_type is bool:
+            return repr(value)
+        if value_type is int or value_type is float and isfinite(value):
+            code = repr(value)
+            # e.g. (-2) ** 2
+            return f"({code})" if code.startswith("-") else code
+        if (value_type is str or value_type is bytes) and len(value) < 128:
+            code = repr(value)
+            if "%" not in code and "{" not in code:
+                return code
+        return None
+
     def _gen_code_and_update_ctx(self, code_input, ctx):
         if self.code_str:
             return self.code_str
@@ -1490,6 +2011,9 @@ class NaiveConversion(BaseConversion):
     def is_itself_callable(self) -> Optional[bool]:
         return callable(self.value)
 
+    def get_constant(self) -> "Any":
+        return self.value
+
     def call(self, *args, **kwargs) -> "Call":
         conv = super().call(*args, **kwargs)
         try:
@@ -1690,9 +2214,15 @@ class FunctionCtx:
         self.prev_names_to_warm_up = None
         self.optimize_naive = optimize_naive
         self.naive_to_optimize = None
+        self.prev_cse_substitutions = None
 
     def gen_function(self, name, code):
-        return self.ctx[self.compile_n_return_name(name, code)]
+        return self.get_function(self.compile_n_return_name(name, code))
+
+    def get_function(self, name):
+        if name not in self.ctx:
+            self.conversion._compile_pending_sources(self.ctx)
+        return self.ctx[name]
 
     def gen_conversion(self, name, code):
         return EscapedString(self.compile_n_return_name(name, code))
@@ -1745,6 +2275,11 @@ class FunctionCtx:
 
     def __enter__(self):
         self.prev_names_to_warm_up = self.ctx[BaseConversion.NAIVE_TO_WARM_UP]
+        # hoisted variables are not available inside of the new function
+        self.prev_cse_substitutions = self.ctx[
+            BaseConversion.CSE_SUBSTITUTIONS
+        ]
+        self.ctx[BaseConversion.CSE_SUBSTITUTIONS] = None
         if self.optimize_naive:
             self.naive_to_optimize = self.ctx[
                 BaseConversion.NAIVE_TO_WARM_UP
@@ -1755,6 +2290,9 @@ class FunctionCtx:
 
     def __exit__(self, exc_type, exc_value, exc_traceback):
         self.ctx[BaseConversion.NAIVE_TO_WARM_UP] = self.prev_names_to_warm_up
+        self.ctx[BaseConversion.CSE_SUBSTITUTIONS] = (
+            self.prev_cse_substitutions
+        )
         return self.namespace_ctx.__exit__(exc_type, exc_value, exc_traceback)
 
 
@@ -1852,6 +2390,89 @@ class LazyEscapedString(BaseConversion):
         raise ValueError("LazyEscapedString is left uninitialized", self.name)
 
 
+#: types of constants, which are safe to be computed at code generation time
+FOLDABLE_TYPES = frozenset(
+    [type(None), bool, int, float, complex, str, bytes]
+)
+#: InlineExpr code of operators, which are folded if args are constants
+FOLDABLE_OPERATORS = {
+    "not {0}": operator.not_,
+    "-{0}": operator.neg,
+    "{0} in {1}": lambda a, b: a in b,
+    "{0} not in {1}": lambda a, b: a not in b,
+    "{0} != {1}": operator.ne,
+    "{0} > {1}": operator.gt,
+    "{0} >= {1}": operator.ge,
+    "{0} < {1}": operator.lt,
+    "{0} <= {1}": operator.le,
+    "{0} + {1}": operator.add,
+    "{0} * {1}": operator.mul,
+    "{0} ** {1}": operator.pow,
+    "{0} - {1}": operator.sub,
+    "{0} / {1}": operator.truediv,
+    "{0} % {1}": operator.mod,
+    "{0} // {1}": operator.floordiv,
+}
+# results of folding are kept small: no huge strings or numbers
+MAX_FOLDED_REPEAT = 256
+MAX_FOLDED_EXPONENT = 256
+MAX_FOLDED_INT_BITS = 4096
+MAX_FOLDED_LENGTH = 4096
+
+
+def get_foldable_constant(conversion) -> "Any":
+    """Return the constant value of a conversion if it is safe to fold."""
+    value = conversion.get_constant()
+    if type(value) in FOLDABLE_TYPES:
+        return value
+    return _none
+
+
+def fold_operator(code_str, args) -> "Any":
+    """Compute an operator of constants; returns _none if not possible.
+
+    Operations, which raise, are left to raise at runtime.
+    """
+    func = FOLDABLE_OPERATORS.get(code_str)
+    if func is None or code_str.count("{") != len(args):
+        return _none
+    values = [get_foldable_constant(arg) for arg in args]
+    if any(value is _none for value in values):
+        return _none
+
+    if func is operator.mul:
+        # repeating a sequence
+        if any(type(value) in (str, bytes) for value in values) and any(
+            type(value) is int and value > MAX_FOLDED_REPEAT
+            for value in values
+        ):
+            return _none
+    elif func is operator.pow:
+        if type(values[1]) is int and values[1] > MAX_FOLDED_EXPONENT:
+            return _none
+    elif func is operator.mod:
+        # printf-style formatting
+        if type(values[0]) in (str, bytes):
+            return _none
+
+    try:
+        result = func(*values)
+    except Exception:  # pylint: disable=broad-except
+        return _none
+    result_type = type(result)
+    if result_type not in FOLDABLE_TYPES:
+        return _none
+    # chained operations are folded one by one, so results are capped too
+    if (
+        result_type is int
+        and result.bit_length() > MAX_FOLDED_INT_BITS
+        or result_type in (str, bytes)
+        and len(result) > MAX_FOLDED_LENGTH
+    ):
+        return _none
+    return result
+
+
 class OrAndEqBaseConversion(BaseConversion):
     """Base class of Or/And/Eq operator conversions."""
 
@@ -1862,6 +2483,9 @@ class OrAndEqBaseConversion(BaseConversion):
 
     op = ""
     weight = Weights.LOGICAL
+    # truth value of a constant, which short-circuits the expression;
+    # None - the operator does not support pruning of constant args
+    short_circuit_on: "Optional[bool]" = None
 
     def __init__(self, *args, default=None):
         """Initialize operator.
@@ -1878,12 +2502,57 @@ class OrAndEqBaseConversion(BaseConversion):
         if not args and default is None:
             raise ValueError("neither args nor default is provided")
 
-        self.args = [self.ensure_conversion(arg) for arg in args]
+        conversions = [ensure_conversion(arg) for arg in args]
+        if self.short_circuit_on is not None:
+            conversions = self.prune_constant_args(conversions)
+        self.args = [self.ensure_conversion(arg) for arg in conversions]
         self.default = default
+        self.constant = self.fold_args()
+        if self.constant is not _none:
+            self.total_weight = Weights.STEP
+
+    def prune_constant_args(self, conversions):
+        """Drop constants, which do not affect the result."""
+        pruned = []
+        for index, conversion in enumerate(conversions):
+            value = get_foldable_constant(conversion)
+            if value is _none:
+                pruned.append(conversion)
+            elif bool(value) is self.short_circuit_on:
+                pruned.append(conversion)
+                break
+            elif index == len(conversions) - 1:
+                pruned.append(conversion)
+        return pruned
+
+    def fold_args(self):
+        if not self.args:
+            return _none
+        values = [get_foldable_constant(arg) for arg in self.args]
+        if any(value is _none for value in values):
+            return _none
+        if self.short_circuit_on is not None:
+            # all but the last one are dropped by pruning
+            return values[-1] if len(values) == 1 else _none
+        if len(values) == 1:
+            # nothing to compare, the operand is returned as is
+            return values[0]
+        # chained comparison
+        return all(
+            values[index] == values[index + 1]
+            for index in range(len(values) - 1)
+        )
+
+    def get_constant(self) -> "Any":
+        return self.constant
 
     def _gen_code_and_update_ctx(self, code_input, ctx):
         if not self.args:
             return repr(bool(self.default))
+        if self.constant is not _none:
+            return NaiveConversion(self.constant).gen_code_and_update_ctx(
+                code_input, ctx
+            )
 
         code = self.op.join(
             [arg.gen_code_and_update_ctx(code_input, ctx) for arg in self.args]
@@ -1902,6 +2571,7 @@ class Or(OrAndEqBaseConversion):
     """
 
     op = " or "
+    short_circuit_on = True
 
 
 class And(OrAndEqBaseConversion):
@@ -1915,6 +2585,7 @@ class And(OrAndEqBaseConversion):
     """
 
     op = " and "
+    short_circuit_on = False
 
 
 class Eq(OrAndEqBaseConversion):
@@ -1965,6 +2636,15 @@ class If(BaseConversion):
         if_false = (
             this if if_false is self._none else ensure_conversion(if_false)
         )
+        condition_value = get_foldable_constant(if_cond)
+        self.is_pruned = condition_value is not _none
+        if self.is_pruned:
+            # dead branch is pruned
+            self.conversion = self.ensure_conversion(
+                if_true if condition_value else if_false
+            )
+            return
+
         conversion = InlineExpr(
             "({if_true} if {if_cond} else {if_false})"
         ).pass_args(
@@ -1986,6 +2666,9 @@ class If(BaseConversion):
 
         self.conversion = self.ensure_conversion(conversion)
 
+    def get_constant(self) -> "Any":
+        return self.conversion.get_constant()
+
     def _gen_code_and_update_ctx(self, code_input, ctx):
         return self.conversion.gen_code_and_update_ctx(code_input, ctx)
 
@@ -2023,13 +2706,33 @@ class IfMultiple(BaseConversion):
           else_: default to return if no conditions evaluated to true.
         """
         super().__init__()
+        else_ = ensure_conversion(else_)
+        pairs = []
+        for condition, value in condition_to_value_pairs:
+            condition = ensure_conversion(condition)
+            condition_value = get_foldable_constant(condition)
+            if condition_value is _none:
+                pairs.append((condition, value))
+            elif condition_value:
+                # the rest is unreachable
+                else_ = ensure_conversion(value)
+                break
+
         self.condition_to_value_pairs = [
             (self.ensure_conversion(condition), self.ensure_conversion(value))
-            for condition, value in condition_to_value_pairs
+            for condition, value in pairs
         ]
         self.else_ = self.ensure_conversion(else_)
 
+    def get_constant(self) -> "Any":
+        if self.condition_to_value_pairs:
+            return _none
+        return self.else_.get_constant()
+
     def _gen_code_and_update_ctx(self, code_input, ctx):
+        if not self.condition_to_value_pairs:
+            return self.else_.gen_code_and_update_ctx(code_input, ctx)
+
         code = Code()
         suffix = self.gen_random_name("_", ctx)
         converter_name = f"if_multiple{suffix}"
@@ -2071,8 +2774,15 @@ class Not(BaseConversion):
     def __init__(self, arg):
         super().__init__()
         self.arg = self.ensure_conversion(arg)
+        value = get_foldable_constant(self.arg)
+        self.constant = _none if value is _none else not value
+
+    def get_constant(self) -> "Any":
+        return self.constant
 
     def _gen_code_and_update_ctx(self, code_input, ctx):
+        if self.constant is not _none:
+            return repr(self.constant)
         code = self.arg.gen_code_and_update_ctx(code_input, ctx)
         return f"(not {code})"
 
@@ -2117,6 +2827,16 @@ class InlineExpr(BaseConversion):
             if kwargs
             else {}
         )
+        self.constant = (
+            _none
+            if self.kwargs
+            else fold_operator(self.code_str, self.args)
+        )
+        if self.constant is not _none:
+            self.total_weight = Weights.STEP
+
+    def get_constant(self) -> "Any":
+        return self.constant
 
     def pass_args(self, *args, **kwargs):
         """The method passes arguments to the code to be inlined.
@@ -2132,6 +2852,10 @@ class InlineExpr(BaseConversion):
         return InlineExpr(self.code_str, self.weight, args, kwargs)
 
     def _gen_code_and_update_ctx(self, code_input, ctx):
+        if self.constant is not _none:
+            return NaiveConversion(self.constant).gen_code_and_update_ctx(
+                code_input, ctx
+            )
         code = self.code_str.format(
             *(
                 arg.gen_code_and_update_ctx(code_input, ctx)
@@ -2280,10 +3004,13 @@ class GetItem(BaseMethodConversion):
     def _gen_code_and_update_ctx(self, code_input, ctx):
         code_self, code_input = self.get_self_and_input_code(code_input, ctx)
         if self.default is None:
+            substitutions = ctx[self.CSE_SUBSTITUTIONS]
             code_output = code_self
             for index in self.indexes:
                 code_index = index.gen_code_and_update_ctx(code_input, ctx)
                 code_output = self.wrap_path_item(code_output, code_index)
+                if substitutions and code_output in substitutions:
+                    code_output = substitutions[code_output]
             return code_output
 
         if self.hardcoded_version is not None:
@@ -2505,7 +3232,8 @@ class BaseComp(BaseMethodConversion):
         )
         self.number_of_input_uses = 1
 
-    def get_item_n_param_codes(self, ctx):
+    def get_comprehension_codes(self, code_input, ctx):
+        """Return item, param, iterable and condition codes."""
         if self.generator_item.custom_for_params:
             param_code = ", ".join(
                 param.gen_code_and_update_ctx(None, ctx)
@@ -2514,29 +3242,570 @@ class BaseComp(BaseMethodConversion):
             item_code = self.generator_item.item.gen_code_and_update_ctx(
                 None, ctx
             )
+            cse = None
         else:
+            fused_comps = self.get_fused_comps(ctx)
+            if fused_comps:
+                return self.get_fused_comprehension_codes(
+                    fused_comps, code_input, ctx
+                )
+
             param_code = self.gen_random_name("i", ctx)
-            item_code = self.generator_item.item.gen_code_and_update_ctx(
-                param_code, ctx
+            cse = CommonSubexpressions.hoist(
+                self, param_code, [self.generator_item.item], self.where, ctx
             )
-        return item_code, param_code
+            with CseSubstitutionsCtx(ctx, cse and cse.substitutions):
+                item_code = self.generator_item.item.gen_code_and_update_ctx(
+                    param_code, ctx
+                )
 
-    def get_iterable_code(self, code_input, ctx):
         code_self, _ = self.get_self_and_input_code(code_input, ctx)
-        return code_self
+        code_iterable, condition_code = gen_comprehension_codes(
+            code_self, self.where, param_code, ctx, cse
+        )
+        return item_code, param_code, code_iterable, condition_code
+
+    def get_fused_comps(self, ctx) -> "List[GeneratorComp]":
+        """Return generator comprehensions to be fused into this one.
+
+        Innermost first, empty if there are none or fusing is disabled. Stages
+        of instrumented converters are counted separately, so they are not
+        fused.
+        """
+        if (
+            not CodeGenerationOptionsCtx.get_option_value("fuse_pipelines")
+            or ctx[BaseConversion.RUNTIME_COUNTERS] is not None
+        ):
+            return []
+
+        comps = []
+        comp = self.self_conv
+        while (
+            type(comp) is GeneratorComp
+            and not comp.generator_item.custom_for_params
+        ):
+            comps.append(comp)
+            comp = comp.self_conv
+        comps.reverse()
+        return comps
+
+    def get_fused_comprehension_codes(self, fused_comps, code_input, ctx):
+        """Generate a chain of comprehensions as a single one.
+
+        Items of consumed comprehensions are bound by extra ``for`` clauses,
+        which python compiles to plain assignments:
+        ``[j + 1 for i in data if i for j in (i["a"],) if j]``.
+        """
+        code_iterable, _ = fused_comps[0].get_self_and_input_code(
+            code_input, ctx
+        )
+        param_code = first_param_code = self.gen_random_name("i", ctx)
+        code = ""
+        for comp in chain(fused_comps, (self,)):
+            item = comp.generator_item.item
+            cse = CommonSubexpressions.hoist(
+                comp, param_code, [item], comp.where, ctx
+            )
+            with CseSubstitutionsCtx(ctx, cse and cse.substitutions):
+                item_code = item.gen_code_and_update_ctx(param_code, ctx)
+
+            if code_iterable is None:
+                # the previous stage passes elements through as is
+                code_bindings, condition_code = gen_comprehension_codes(
+                    "", comp.where, param_code, ctx, cse
+                )
+                code += code_bindings
+            else:
+                code_iterable, condition_code = gen_comprehension_codes(
+                    code_iterable, comp.where, param_code, ctx, cse
+                )
+                code += (
+                    f" for {param_code} in {code_iterable}"
+                    if code
+                    else code_iterable
+                )
+            if condition_code is not None:
+                code += f" if {condition_code}"
+
+            if comp is self:
+                break
+            if item is This:
+                code_iterable = None
+            else:
+                param_code = self.gen_random_name("i", ctx)
+                code_iterable = f"({item_code},)"
+
+        return item_code, first_param_code, code, None
+
+
+class CseSubstitutionsCtx:
+    """Makes hoisted variables available to lookups generated within."""
+
+    def __init__(self, ctx, substitutions):
+        self.ctx = ctx
+        self.substitutions = substitutions
+        self.prev_substitutions = None
+
+    def __enter__(self):
+        if self.substitutions:
+            self.prev_substitutions = self.ctx[
+                BaseConversion.CSE_SUBSTITUTIONS
+            ]
+            self.ctx[BaseConversion.CSE_SUBSTITUTIONS] = (
+                {**self.prev_substitutions, **self.substitutions}
+                if self.prev_substitutions
+                else self.substitutions
+            )
+        return self
+
+    def __exit__(self, exc_type, exc_value, exc_traceback):
+        if self.substitutions:
+            self.ctx[BaseConversion.CSE_SUBSTITUTIONS] = (
+                self.prev_substitutions
+            )
+
+
+class CommonSubexpressions:
+    """Hoists lookups, repeated within a comprehension row, into variables.
+
+    Only chains of ``item`` lookups (without defaults) of a row are
+    considered: ``attr`` ones may hit properties with side effects. Hoisted
+    lookups are evaluated earlier, so rows failing several lookups may raise
+    a different exception. A chain is hoisted if it is evaluated at least once
+    unconditionally (so hoisting cannot raise where the original code would
+    not) and is used at least twice. Rows of comprehensions, which call
+    arbitrary functions or methods, use mutations or labels, are left
+    untouched, because calls may modify the row between lookups.
+
+    Variables are bound by extra comprehension clauses:
+    ``[v_a["x"] + v_a["y"] for i in data for v_a in (i["a"],)]``. Chains,
+    which are evaluated unconditionally only after the ``if`` clause, are
+    bound after it.
+    """
+
+    pure_callables = frozenset(
+        [
+            abs,
+            all,
+            any,
+            bool,
+            bytes,
+            dict,
+            float,
+            frozenset,
+            get_1_or_default,
+            get_2_or_default,
+            get_3_or_default,
+            hash,
+            int,
+            isinstance,
+            len,
+            list,
+            max,
+            min,
+            repr,
+            round,
+            set,
+            sorted,
+            str,
+            sum,
+            tuple,
+            Decimal,
+        ]
+    )
+    pure_methods = frozenset(
+        [
+            "count",
+            "endswith",
+            "get",
+            "index",
+            "isdigit",
+            "items",
+            "keys",
+            "lower",
+            "lstrip",
+            "rstrip",
+            "split",
+            "startswith",
+            "strip",
+            "upper",
+            "values",
+        ]
+    )
+    # InlineExpr with calls or lambdas is opaque
+    pattern_inline_call = re.compile(r"[\w)\]}]\s*\(|\blambda\b|:=")
+    pattern_inline_conditional = re.compile(r"\b(?:if|and|or|for)\b")
+
+    # markers of where an occurrence is evaluated unconditionally
+    IN_CONDITION = 1
+    IN_ITEMS = 2
+
+    def __init__(self):
+        self.is_pure = True
+        # path (tuple of step keys) to steps of its first occurrence
+        self.path_to_steps = {}
+        # path to [number of uses in condition, in items, unconditional in]
+        self.path_to_stats = {}
+        self.substitutions = None
+        self.condition_substitutions = None
+        self.condition_bindings = None
+        self.item_bindings = None
+
+    @classmethod
+    def hoist(
+        cls, conversion, param_code, items, where, ctx
+    ) -> "Optional[CommonSubexpressions]":
+        """Analyze a comprehension row and generate bindings if needed."""
+        if not CodeGenerationOptionsCtx.get_option_value(
+            "common_subexpressions"
+        ):
+            return None
+        self = cls()
+        if not isinstance(where, _None):
+            self.visit(where, self.IN_CONDITION, True)
+        for item in items:
+            self.visit(item, self.IN_ITEMS, True)
+        if not self.is_pure or not self.path_to_stats:
+            return None
+
+        hoisted = self.choose_paths()
+        if not hoisted:
+            return None
+
+        self.substitutions = {}
+        self.condition_substitutions = {}
+        self.condition_bindings = []
+        self.item_bindings = []
+        for path, in_condition in hoisted:
+            lookup = None
+            for lookup_cls, index in self.path_to_steps[path]:
+                lookup = (
+                    lookup_cls(index)
+                    if lookup is None
+                    else lookup_cls(index, self_conv=lookup)
+                )
+            with CseSubstitutionsCtx(ctx, self.substitutions):
+                code = lookup.gen_code_and_update_ctx(param_code, ctx)
+            var_name = conversion.gen_random_name("v", ctx)
+            self.substitutions[code] = var_name
+            if in_condition:
+                self.condition_substitutions[code] = var_name
+                self.condition_bindings.append((var_name, code))
+            else:
+                self.item_bindings.append((var_name, code))
+        return self
+
+    def choose_paths(self):
+        """Return (path, is bound before condition) pairs to be hoisted."""
+        path_to_children = {}
+        for path in self.path_to_stats:
+            if len(path) > 1:
+                path_to_children.setdefault(path[:-1], []).append(path)
+
+        def get_uses(path):
+            in_condition, in_items, unconditional_in = self.path_to_stats[
+                path
+            ]
+            if unconditional_in & self.IN_CONDITION:
+                return in_condition + in_items, True
+            if unconditional_in & self.IN_ITEMS:
+                return in_items, False
+            return 0, False
+
+        hoisted = []
+        path_to_hoisted_length = {}
+        for path in sorted(self.path_to_stats, key=len):
+            uses, in_condition = get_uses(path)
+            ancestor_length = path_to_hoisted_length.get(path[:-1], 0)
+            path_to_hoisted_length[path] = ancestor_length
+            if uses < 2:
+                continue
+
+            children = path_to_children.get(path, ())
+            if len(children) == 1 and get_uses(children[0]) == (
+                uses,
+                in_condition,
+            ):
+                # the longer chain is to be hoisted instead
+                continue
+
+            if (uses - 1) * (
+                len(path) - ancestor_length
+            ) * Weights.DICT_LOOKUP < Weights.STEP:
+                continue
+
+            hoisted.append((path, in_condition))
+            path_to_hoisted_length[path] = len(path)
+        return hoisted
+
+    def get_lookup_steps(self, conversion):
+        """Return steps of a chain of lookups of a row or None."""
+        if (
+            conversion.default is not None
+            or conversion.hardcoded_version is not None
+            or not conversion.indexes_are_simple
+        ):
+            return None
+        self_conv = conversion.self_conv
+        if self_conv is BaseConversion._none or isinstance(
+            self_conv, ThisConversion
+        ):
+            steps = []
+        elif isinstance(self_conv, GetItem):
+            steps = self.get_lookup_steps(self_conv)
+            if steps is None:
+                return None
+        else:
+            return None
+
+        # attribute lookups may run properties, so they are not hoisted
+        if type(conversion) is not GetItem:
+            return None
+        for index in conversion.indexes:
+            steps.append((GetItem, index))
+        return steps
+
+    def add_occurrence(self, steps, marker, unconditional):
+        path = ()
+        for lookup_cls, index in steps:
+            path += ((lookup_cls, gen_structural_key(index)),)
+            if path not in self.path_to_steps:
+                self.path_to_steps[path] = steps[: len(path)]
+                self.path_to_stats[path] = [0, 0, 0]
+            stats = self.path_to_stats[path]
+            stats[0 if marker == self.IN_CONDITION else 1] += 1
+            if unconditional:
+                stats[2] |= marker
+
+    def is_pure_call(self, conversion):
+        self_conv = conversion.self_conv
+        if isinstance(self_conv, NaiveConversion):
+            try:
+                return self_conv.value in self.pure_callables
+            except TypeError:
+                return False
+        return (
+            type(self_conv) is GetAttr
+            and self_conv.default is None
+            and len(self_conv.indexes) == 1
+            and isinstance(self_conv.indexes[0], NaiveConversion)
+            and self_conv.indexes[0].value in self.pure_methods
+        )
+
+    def visit(self, conversion, marker, unconditional):
+        if not self.is_pure:
+            return
+        if conversion.contents & (
+            BaseConversion.ContentTypes.NEW_LABEL
+            | BaseConversion.ContentTypes.REDUCER
+            | BaseConversion.ContentTypes.BREAKPOINT
+        ):
+            self.is_pure = False
+            return
+
+        if isinstance(conversion, GetItem):
+            steps = self.get_lookup_steps(conversion)
+            if steps is not None:
+                self.add_occurrence(steps, marker, unconditional)
+            elif conversion.hardcoded_version is not None:
+                self.visit(conversion.hardcoded_version, marker, unconditional)
+            else:
+                if conversion.self_conv is not BaseConversion._none:
+                    self.visit(conversion.self_conv, marker, unconditional)
+                # non-simple indexes and defaults are evaluated in a helper
+                self.scan(conversion)
+
+        elif isinstance(conversion, Call):
+            if not self.is_pure_call(conversion):
+                self.is_pure = False
+                return
+            if isinstance(conversion.self_conv, GetAttr):
+                self_conv = conversion.self_conv.self_conv
+                if self_conv is not BaseConversion._none:
+                    self.visit(self_conv, marker, unconditional)
+            for arg in chain(conversion.args, conversion.kwargs.values()):
+                self.visit(arg, marker, unconditional)
+
+        elif isinstance(conversion, If):
+            inline_expr = conversion.conversion
+            if conversion.is_pruned:
+                self.visit(inline_expr, marker, unconditional)
+                return
+            if isinstance(inline_expr, PipeConversion):
+                if not inline_expr.to_be_inlined:
+                    self.scan(inline_expr)
+                    return
+                inline_expr = inline_expr.where
+            self.visit(inline_expr.kwargs["if_cond"], marker, unconditional)
+            self.visit(inline_expr.kwargs["if_true"], marker, False)
+            self.visit(inline_expr.kwargs["if_false"], marker, False)
+
+        elif isinstance(conversion, InlineExpr):
+            if self.pattern_inline_call.search(conversion.code_str):
+                self.is_pure = False
+                return
+            args_unconditional = (
+                unconditional
+                and self.pattern_inline_conditional.search(
+                    conversion.code_str
+                )
+                is None
+            )
+            for arg in chain(conversion.args, conversion.kwargs.values()):
+                self.visit(arg, marker, args_unconditional)
+
+        elif isinstance(conversion, OrAndEqBaseConversion):
+            # Eq of 3+ args is a chained comparison, so it short-circuits
+            number_of_unconditional = 2 if isinstance(conversion, Eq) else 1
+            for index, arg in enumerate(conversion.args):
+                self.visit(
+                    arg,
+                    marker,
+                    unconditional and index < number_of_unconditional,
+                )
+
+        elif isinstance(conversion, Not):
+            self.visit(conversion.arg, marker, unconditional)
+
+        elif isinstance(conversion, PipeConversion):
+            self.visit(conversion.what, marker, unconditional)
+            if conversion.to_be_inlined and isinstance(
+                conversion.what, ThisConversion
+            ):
+                self.visit(conversion.where, marker, unconditional)
+            else:
+                self.scan(conversion.where)
+
+        elif (
+            isinstance(conversion, BaseCollectionConversion)
+            and conversion.conditions is None
+        ):
+            if conversion.pairs is not None:
+                for key, value in conversion.pairs:
+                    self.visit(key, marker, unconditional)
+                    self.visit(value, marker, unconditional)
+            else:
+                for item in conversion.conversions or ():
+                    self.visit(item, marker, unconditional)
+
+        elif not isinstance(
+            conversion,
+            (
+                ThisConversion,
+                NaiveConversion,
+                EscapedString,
+                InputArg,
+                LabelConversion,
+            ),
+        ):
+            self.scan(conversion)
+
+    def scan(self, conversion):
+        """Ensure an opaque part of a row has no side effects."""
+        memo = set()
+        stack = [conversion]
+        while stack and self.is_pure:
+            obj = stack.pop()
+            if isinstance(obj, (list, tuple)):
+                stack.extend(obj)
+                continue
+            if isinstance(obj, dict):
+                stack.extend(obj.values())
+                continue
+            if isinstance(obj, GeneratorItem):
+                stack.append(obj.item)
+                stack.extend(obj.custom_for_params)
+                continue
+            if not isinstance(obj, BaseConversion) or id(obj) in memo:
+                continue
+            memo.add(id(obj))
+
+            if (
+                isinstance(obj, BaseMutation)
+                or obj.contents & BaseConversion.ContentTypes.NEW_LABEL
+                or (
+                    isinstance(obj, Call)
+                    and not self.is_pure_call(obj)
+                )
+                or (
+                    isinstance(obj, InlineExpr)
+                    and self.pattern_inline_call.search(obj.code_str)
+                )
+            ):
+                self.is_pure = False
+                return
+            stack.extend(
+                value
+                for name, value in obj.__dict__.items()
+                if name != "_depends_on"
+            )
+
+
+def gen_comprehension_codes(code_iterable, where, param_code, ctx, cse=None):
+    """Return iterable and condition (None if no where) comprehension codes.
+
+    If the converter is instrumented, rows taken from the iterable and rows
+    passing the condition are counted. Hoisted common subexpressions are bound
+    by extra ``for`` clauses.
+    """
+    with CseSubstitutionsCtx(ctx, cse and cse.condition_substitutions):
+        condition_code = (
+            None
+            if isinstance(where, _None)
+            else where.gen_code_and_update_ctx(param_code, ctx)
+        )
+    runtime_counters = ctx[BaseConversion.RUNTIME_COUNTERS]
+    if runtime_counters is not None:
+        if condition_code is None:
+            counters = runtime_counters.add_stage("iter", "rows_in")
+            counters["rows_out"] = counters["rows_in"]
+        else:
+            counters = runtime_counters.add_stage(
+                "filter", "rows_in", "rows_out"
+            )
+            code_counter = NaiveConversion(
+                counters["rows_out"].counter
+            ).gen_code_and_update_ctx(None, ctx)
+            condition_code = (
+                f"({condition_code}) and next({code_counter}) >= 0"
+            )
+
+        code_iterable = (
+            NaiveConversion(counters["rows_in"].count_iter)
+            .call(EscapedString(code_iterable))
+            .gen_code_and_update_ctx(None, ctx)
+        )
+
+    if cse is not None:
+        code_iterable += "".join(
+            f" for {var_name} in ({code},)"
+            for var_name, code in cse.condition_bindings
+        )
+        item_bindings_code = "".join(
+            f" for {var_name} in ({code},)"
+            for var_name, code in cse.item_bindings
+        )
+        if condition_code is None:
+            code_iterable += item_bindings_code
+        else:
+            condition_code += item_bindings_code
+    return code_iterable, condition_code
 
 
 class GeneratorComp(BaseComp):
     """Generates python generator comprehension code."""
 
     def _gen_code_and_update_ctx(self, code_input, ctx):
-        item_code, param_code = self.get_item_n_param_codes(ctx)
-        code_iterable = self.get_iterable_code(code_input, ctx)
-
-        if isinstance(self.where, _None):
+        (
+            item_code,
+            param_code,
+            code_iterable,
+            condition_code,
+        ) = self.get_comprehension_codes(code_input, ctx)
+
+        if condition_code is None:
             return f"({item_code} for {param_code} in {code_iterable})"
 
-        condition_code = self.where.gen_code_and_update_ctx(param_code, ctx)
         return f"({item_code} for {param_code} in {code_iterable} if {condition_code})"
 
     def to_iter(self):
@@ -2570,6 +3839,44 @@ class GeneratorComp(BaseComp):
             self.self_conv,
         )
 
+    def pipe(
+        self,
+        next_conversion,
+        *args,
+        label_input=None,
+        label_output=None,
+        **kwargs,
+    ) -> "BaseConversion":
+        # c.iter(...).pipe(c.filter(...)) is the same as
+        # c.iter(...).filter(...), so it can be fused
+        if (
+            isinstance(next_conversion, BaseComp)
+            and (
+                next_conversion.self_conv is This
+                or next_conversion.self_conv is _none
+            )
+            and not next_conversion.generator_item.custom_for_params
+            and label_input is None
+            and label_output is None
+            and not args
+            and not kwargs
+        ):
+            result = self.iter(
+                next_conversion.generator_item.item,
+                where=next_conversion.where,
+            )
+            if next_conversion.base_type_to_cast is not _none:
+                result = result.as_type(next_conversion.base_type_to_cast)
+            return result
+
+        return super().pipe(
+            next_conversion,
+            *args,
+            label_input=label_input,
+            label_output=label_output,
+            **kwargs,
+        )
+
     def as_type(self, callable_):
         value = NaiveConversion.get_value(callable_)
         if value is list:
@@ -2593,13 +3900,16 @@ class SetComp(BaseComp):
     base_type_to_cast = set
 
     def _gen_code_and_update_ctx(self, code_input, ctx):
-        item_code, param_code = self.get_item_n_param_codes(ctx)
-        code_iterable = self.get_iterable_code(code_input, ctx)
-
-        if isinstance(self.where, _None):
+        (
+            item_code,
+            param_code,
+            code_iterable,
+            condition_code,
+        ) = self.get_comprehension_codes(code_input, ctx)
+
+        if condition_code is None:
             return f"{{{item_code} for {param_code} in {code_iterable}}}"
 
-        condition_code = self.where.gen_code_and_update_ctx(param_code, ctx)
         return f"{{{item_code} for {param_code} in {code_iterable} if {condition_code}}}"
 
     def as_type(self, callable_):
@@ -2614,13 +3924,16 @@ class ListComp(BaseComp):
     base_type_to_cast = list
 
     def _gen_code_and_update_ctx(self, code_input, ctx):
-        item_code, param_code = self.get_item_n_param_codes(ctx)
-        code_iterable = self.get_iterable_code(code_input, ctx)
-
-        if isinstance(self.where, _None):
+        (
+            item_code,
+            param_code,
+            code_iterable,
+            condition_code,
+        ) = self.get_comprehension_codes(code_input, ctx)
+
+        if condition_code is None:
             return f"[{item_code} for {param_code} in {code_iterable}]"
 
-        condition_code = self.where.gen_code_and_update_ctx(param_code, ctx)
         return f"[{item_code} for {param_code} in {code_iterable} if {condition_code}]"
 
     def to_iter(self):
@@ -2644,13 +3957,16 @@ class TupleComp(BaseComp):
     base_type_to_cast = tuple
 
     def _gen_code_and_update_ctx(self, code_input, ctx):
-        item_code, param_code = self.get_item_n_param_codes(ctx)
-        code_iterable = self.get_iterable_code(code_input, ctx)
-
-        if isinstance(self.where, _None):
+        (
+            item_code,
+            param_code,
+            code_iterable,
+            condition_code,
+        ) = self.get_comprehension_codes(code_input, ctx)
+
+        if condition_code is None:
             return f"tuple({item_code} for {param_code} in {code_iterable})"
 
-        condition_code = self.where.gen_code_and_update_ctx(param_code, ctx)
         return f"tuple({item_code} for {param_code} in {code_iterable} if {condition_code})"
 
     def to_iter(self):
@@ -2692,19 +4008,21 @@ class DictComp(BaseMethodConversion):
         )
         self.number_of_input_uses = 1
 
-    def get_iterable_code(self, code_input, ctx):
-        code_self, _ = self.get_self_and_input_code(code_input, ctx)
-        return code_self
-
     def _gen_code_and_update_ctx(self, code_input, ctx):
         param_code = self.gen_random_name("i", ctx)
-        key_code = self.key.gen_code_and_update_ctx(param_code, ctx)
-        value_code = self.value.gen_code_and_update_ctx(param_code, ctx)
-        code_iterable = self.get_iterable_code(code_input, ctx)
-        if isinstance(self.where, _None):
+        cse = CommonSubexpressions.hoist(
+            self, param_code, [self.key, self.value], self.where, ctx
+        )
+        with CseSubstitutionsCtx(ctx, cse and cse.substitutions):
+            key_code = self.key.gen_code_and_update_ctx(param_code, ctx)
+            value_code = self.value.gen_code_and_update_ctx(param_code, ctx)
+        code_self, _ = self.get_self_and_input_code(code_input, ctx)
+        code_iterable, condition_code = gen_comprehension_codes(
+            code_self, self.where, param_code, ctx, cse
+        )
+        if condition_code is None:
             return f"{{{key_code}: {value_code} for {param_code} in {code_iterable}}}"
 
-        condition_code = self.where.gen_code_and_update_ctx(param_code, ctx)
         return f"{{{key_code}: {value_code} for {param_code} in {code_iterable} if {condition_code}}}"
 
     def filter(self, condition_conv, cast=BaseConversion._none):
@@ -2819,13 +4137,19 @@ class BaseCollectionConversion(BaseConversion):
             conversion
         ).gen_code_and_update_ctx(code_input, ctx)
 
-    def gen_joined_items_code(self, code_input, ctx):
+    def gen_joined_items_code(self, code_input, ctx, index_to_code=None):
+        """Join codes of items, taking ready ones from index_to_code."""
         if self.conversions is None:
             raise AssertionError
 
+        index_to_code = index_to_code or {}
         return ("," if len(self.conversions) < 3 else ",\n").join(
-            item.gen_code_and_update_ctx(code_input, ctx)
-            for item in self.conversions
+            (
+                index_to_code[index]
+                if index in index_to_code
+                else item.gen_code_and_update_ctx(code_input, ctx)
+            )
+            for index, item in enumerate(self.conversions)
         )
 
     def gen_collection_from_items_code(
@@ -2844,11 +4168,46 @@ class BaseCollectionConversion(BaseConversion):
                 ctx,
             )
 
+        grouper_indexes = self.get_grouper_indexes(ctx)
+        if len(grouper_indexes) > 1:
+            from convtools import _aggregations
+
+            return _aggregations.gen_fused_groupers_code(
+                self, grouper_indexes, code_input, ctx
+            )
+
         joined_items_code = self.gen_joined_items_code(code_input, ctx)
         return self.gen_collection_from_items_code(
             joined_items_code, code_input, ctx
         )
 
+    def get_grouper_indexes(self, ctx) -> "List[int]":
+        """Return indexes of items (values of dicts), which are aggregations.
+
+        Aggregations may be piped to other conversions.
+
+        Such aggregations of the same input are fused, unless disabled or
+        the converter is instrumented.
+        """
+        if (
+            not CodeGenerationOptionsCtx.get_option_value("fuse_aggregations")
+            or ctx[self.RUNTIME_COUNTERS] is not None
+        ):
+            return []
+
+        from convtools import _aggregations
+
+        items = (
+            self.conversions
+            if self.pairs is None
+            else [value for _, value in self.pairs]
+        )
+        return [
+            index
+            for index, item in enumerate(items)
+            if _aggregations.unwrap_grouper(item)[0] is not None
+        ]
+
 
 class OptionalCollectionItem(BaseConversion):
     """Make collection item optional, so it conditionally disappears."""
@@ -2980,13 +4339,19 @@ class Dict_(BaseCollectionConversion):
         self.pairs = pairs
         self.conditions = conditions
 
-    def gen_joined_items_code(self, code_input, ctx):
+    def gen_joined_items_code(self, code_input, ctx, index_to_code=None):
         if self.pairs is None:
             raise AssertionError
+
+        index_to_code = index_to_code or {}
         return ("," if len(self.pairs) < 3 else ",\n").join(
             f"{key.gen_code_and_update_ctx(code_input, ctx)}:"
-            f"{value.gen_code_and_update_ctx(code_input, ctx)}"
-            for key, value in self.pairs
+            + (
+                index_to_code[index]
+                if index in index_to_code
+                else value.gen_code_and_update_ctx(code_input, ctx)
+            )
+            for index, (key, value) in enumerate(self.pairs)
         )
 
     def gen_collection_from_generator(self, generator_code, code_input, ctx):
@@ -3125,7 +4490,29 @@ class Dispatcher(BaseConversion):
         default: "Optional[Any]" = None,
     ):
         super().__init__()
-        self.key_getter = self.ensure_conversion(key)
+        key_getter = ensure_conversion(key)
+        self.folded_conversion: "Optional[BaseConversion]" = None
+        key_value = get_foldable_constant(key_getter)
+        if key_value is not _none:
+            # dead branches are pruned; a missing key raises at runtime
+            if key_value in key_to_conv:
+                self.folded_conversion = self.ensure_conversion(
+                    key_to_conv[key_value]
+                )
+            elif default is not None:
+                self.folded_conversion = self.ensure_conversion(default)
+
+        if self.folded_conversion is not None:
+            self.key_getter = key_getter
+            self.key_to_conversion = {}
+            self.default_conversion = None
+            self.number_of_input_uses = (
+                self.folded_conversion.number_of_input_uses
+            )
+            self.total_weight = self.folded_conversion.total_weight
+            return
+
+        self.key_getter = self.ensure_conversion(key_getter)
         self.key_to_conversion = {
             k: self.ensure_conversion(v) for k, v in key_to_conv.items()
         }
@@ -3134,14 +4521,24 @@ class Dispatcher(BaseConversion):
         )
         self.number_of_input_uses = 2
 
+    def get_constant(self) -> "Any":
+        if self.folded_conversion is None:
+            return _none
+        return self.folded_conversion.get_constant()
+
     def _gen_code_and_update_ctx(self, code_input, ctx):
+        if self.folded_conversion is not None:
+            return self.folded_conversion.gen_code_and_update_ctx(
+                code_input, ctx
+            )
+
         converter_name = self.gen_random_name("dispatch", ctx)
         var_input = "data_"
 
         function_ctx = self.as_function_ctx(ctx)
         function_ctx.add_arg(var_input, This())
         with function_ctx:
-            key_to_func = {}
+            key_to_name = {}
             for key, then_conversion in self.key_to_conversion.items():
                 converter_name = self.gen_random_name("branch", ctx)
                 code = Code()
@@ -3154,15 +4551,12 @@ class Dispatcher(BaseConversion):
                     f"return {then_conversion.gen_code_and_update_ctx(var_input, ctx)}",
                     -1,
                 )
-                key_to_func[key] = function_ctx.gen_function(
+                key_to_name[key] = function_ctx.compile_n_return_name(
                     converter_name, code.to_string(0)
                 )
 
-            conversion: "BaseConversion"
-            if self.default_conversion is None:
-                conversion = NaiveConversion(key_to_func).item(self.key_getter)
-
-            else:
+            else_name = None
+            if self.default_conversion is not None:
                 converter_name = self.gen_random_name("branch_else", ctx)
                 code = Code()
                 code.add_line(
@@ -3173,10 +4567,20 @@ class Dispatcher(BaseConversion):
                     f"return {self.default_conversion.gen_code_and_update_ctx(var_input, ctx)}",
                     -1,
                 )
-                else_func = function_ctx.gen_function(
+                else_name = function_ctx.compile_n_return_name(
                     converter_name, code.to_string(0)
                 )
 
+            # branches are referenced as values, so they have to be compiled
+            key_to_func = {
+                key: function_ctx.get_function(name)
+                for key, name in key_to_name.items()
+            }
+            conversion: "BaseConversion"
+            if else_name is None:
+                conversion = NaiveConversion(key_to_func).item(self.key_getter)
+            else:
+                else_func = function_ctx.get_function(else_name)
                 conversion = NaiveConversion(key_to_func).call_method(
                     "get", self.key_getter, else_func
                 )
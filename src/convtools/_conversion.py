@@ -43,17 +43,23 @@ from ._base import (
     This,
     Tuple_,
     TupleComp,
+    converters_cache,
     ensure_conversion,
+    gen_converters,
 )
 from ._chunks import ChunkBy, ChunkByCondition
 from ._columns import ColumnRef
 from ._cumulative import Cumulative
 from ._exceptions import try_multiple
 from ._expect import ExpectException
-from ._joins import JoinConversion, _JoinConditions
+from ._heuristics import calibrate_weights
+from ._export import export_module, provide_injections
+from ._joins import AsofJoinConversion, JoinConversion, _JoinConditions
 from ._mutations import Mutations
 from ._ordering import SortConversion, SortingKeyConversion
+from ._source_maps import source_maps
 from ._try import Try
+from ._utils import CodegenProfiler, bytecode_cache
 from ._window import WindowFuncs
 
 
@@ -87,6 +93,21 @@ class Conversion:
     CodeGenerationOptionsCtx = (  # pylint: disable=invalid-name
         CodeGenerationOptionsCtx
     )
+    #: process-wide LRU cache used by ``gen_converter(cache=True)``
+    converters_cache = converters_cache
+    #: opt-in on-disk cache of compiled code objects
+    bytecode_cache = bytecode_cache
+    #: writes converters to a module, which is importable without code-gen
+    export_module = staticmethod(export_module)
+    provide_injections = staticmethod(provide_injections)
+    #: compiles multiple converters with a single compile call
+    gen_converters = staticmethod(gen_converters)
+    #: opt-in profiler of code generation phases
+    CodegenProfiler = CodegenProfiler
+    #: opt-in mapping of generated code lines to conversions
+    source_maps = source_maps
+    #: measures weights of inlining heuristics on the current host
+    calibrate_weights = staticmethod(calibrate_weights)
 
     ReduceFuncs = ReduceFuncs  # pylint: disable=invalid-name
     WindowFuncs = WindowFuncs  # pylint: disable=invalid-name
@@ -141,6 +162,7 @@ class Conversion:
     aggregate = staticmethod(Aggregate)
 
     join = JoinConversion
+    asof_join = AsofJoinConversion
     LEFT = _JoinConditions.LEFT
     RIGHT = _JoinConditions.RIGHT
 
@@ -0,0 +1,316 @@
+"""Ahead-of-time export of conversions as importable python modules."""
+
+import math
+import re
+import sys
+from collections import namedtuple
+from importlib import import_module
+from types import ModuleType
+from typing import Any, Dict, Mapping, Optional, Tuple
+
+from ._base import BaseConversion, ensure_conversion
+
+
+ExportedModule = namedtuple("ExportedModule", ["source", "injections"])
+
+_name_to_injections: "Dict[str, Dict[str, Any]]" = {}
+
+
+def provide_injections(export_name: str, values: "Mapping[str, Any]"):
+    """Provide values, which exported module cannot express in its code.
+
+    Has to be called before the exported module is imported.
+
+    Args:
+      export_name: ``name`` passed to ``export_module``
+      values: injection name to value mapping, see
+        ``export_module(...).injections``
+    """
+    _name_to_injections.setdefault(export_name, {}).update(values)
+
+
+def get_injections(export_name: str, names: "Tuple[str, ...]"):
+    """Used by exported modules to get injected values."""
+    injections = _name_to_injections.get(export_name, {})
+    missing = [name for name in names if name not in injections]
+    if missing:
+        raise ValueError(
+            "exported module requires injections, call "
+            f"provide_injections({export_name!r}, ...) first",
+            missing,
+        )
+    return {name: injections[name] for name in names}
+
+
+_literal_types = (type(None), bool, int, str, bytes, complex)
+
+
+def gen_literal_code(value) -> "Optional[str]":
+    """Return python code of a literal, which evaluates to an equal value."""
+    value_type = type(value)
+    if value_type in _literal_types:
+        return repr(value)
+    if value_type is float:
+        return repr(value) if math.isfinite(value) else None
+
+    if value_type in (tuple, list, set, frozenset):
+        items_code = []
+        for item in value:
+            item_code = gen_literal_code(item)
+            if item_code is None:
+                return None
+            items_code.append(item_code)
+        if value_type is tuple:
+            trailing_comma = "," if len(items_code) == 1 else ""
+            return f"({', '.join(items_code)}{trailing_comma})"
+        if value_type is list:
+            return f"[{', '.join(items_code)}]"
+        code = f"{{{', '.join(items_code)}}}" if items_code else "set()"
+        return code if value_type is set else f"frozenset({code})"
+
+    if value_type is dict:
+        items_code = []
+        for k, v in value.items():
+            k_code = gen_literal_code(k)
+            v_code = gen_literal_code(v)
+            if k_code is None or v_code is None:
+                return None
+            items_code.append(f"{k_code}: {v_code}")
+        return f"{{{', '.join(items_code)}}}"
+    return None
+
+
+def _resolve(module_name, qualname):
+    obj = import_module(module_name)
+    for attr in qualname.split("."):
+        obj = getattr(obj, attr)
+    return obj
+
+
+def gen_import(value) -> "Optional[Tuple[str, str]]":
+    """Return (module, qualname) to import the value from, if possible."""
+    if isinstance(value, ModuleType):
+        return value.__name__, ""
+
+    owner = getattr(value, "__self__", None)
+    if isinstance(owner, type) and not isinstance(value, type):
+        # bound classmethods like chain.from_iterable
+        owner_import = gen_import(owner)
+        name = getattr(value, "__name__", None)
+        if owner_import and owner_import[1] and name:
+            if getattr(owner, name, None) == value:
+                return owner_import[0], f"{owner_import[1]}.{name}"
+        return None
+
+    module_name = getattr(value, "__module__", None)
+    qualname = getattr(value, "__qualname__", None)
+    if (
+        not isinstance(module_name, str)
+        or not isinstance(qualname, str)
+        or "<" in qualname
+        or module_name == "__main__"
+    ):
+        return None
+    try:
+        if _resolve(module_name, qualname) is value:
+            return module_name, qualname
+    except (ImportError, AttributeError):
+        pass
+    return None
+
+
+class ModuleBuilder:
+    """Collect imports, values and injections of the module to be exported."""
+
+    def __init__(self, export_name):
+        self.export_name = export_name
+        self.import_lines = []
+        self.import_to_alias = {}
+        self.injections = {}
+
+    def import_expr(self, module_name, qualname):
+        if not qualname:
+            key = (module_name, "")
+            if key not in self.import_to_alias:
+                alias = self.import_to_alias[key] = (
+                    f"__import_{len(self.import_to_alias)}"
+                )
+                self.import_lines.append(f"import {module_name} as {alias}")
+            return self.import_to_alias[key]
+
+        first, *rest = qualname.split(".")
+        key = (module_name, first)
+        if key not in self.import_to_alias:
+            alias = self.import_to_alias[key] = (
+                f"__import_{len(self.import_to_alias)}"
+            )
+            self.import_lines.append(
+                f"from {module_name} import {first} as {alias}"
+            )
+        return ".".join((self.import_to_alias[key], *rest))
+
+    def value_expr(self, name, value) -> "Optional[str]":
+        """Code of the value or None if it has to be injected."""
+        code = gen_literal_code(value)
+        if code is not None:
+            return code
+        import_ = gen_import(value)
+        if import_ is not None:
+            return self.import_expr(*import_)
+        self.injections[name] = value
+        return None
+
+
+_name_pattern = re.compile(r"[^\W\d]\w*")
+_ctx_names_to_skip = {
+    "__builtins__",
+    "__debug",
+    "__name__",
+    "__naive_values__",
+    "__none__",
+    "__convtools__code_storage",
+    "__exceptions_to_dump_sources",
+}
+
+
+def export_module(
+    conversions: "Mapping[str, Any]",
+    path: "Optional[str]" = None,
+    name: "Optional[str]" = None,
+) -> ExportedModule:
+    """Generate source code of a module, which defines converters.
+
+    Importing such module involves no code generation. Values, which cannot
+    be expressed as literals or imports (e.g. lambdas, instances of custom
+    classes), are listed in the resulting ``injections`` dict and have to be
+    passed to ``provide_injections`` before the module is imported.
+
+    Args:
+      conversions: converter name to conversion mapping
+      path: (optional) file path to write the source to
+      name: name of the export, used to provide injections; defaults to the
+        file name of ``path``
+
+    Returns:
+      ExportedModule: namedtuple of ``source`` and ``injections``
+    """
+    if name is None:
+        if path is None:
+            raise ValueError("pass either path or name")
+        name = path.replace("\\", "/").rsplit("/", 1)[-1].rsplit(".", 1)[0]
+
+    for converter_name in conversions:
+        if not converter_name.isidentifier() or converter_name.startswith(
+            "_"
+        ):
+            raise ValueError(
+                "converter names should be public identifiers", converter_name
+            )
+
+    ctx = BaseConversion._init_ctx()
+    name_to_generated_name = {}
+    for converter_name, conversion in conversions.items():
+        name_to_generated_name[converter_name] = ensure_conversion(
+            conversion
+        ).gen_converter_in_ctx(ctx, converter_name=converter_name).__name__
+    BaseConversion._cleanup_ctx(ctx)
+
+    code_storage = ctx["__convtools__code_storage"]
+    defined_names = {
+        code_piece.converter_name
+        for code_piece in code_storage.key_to_code_piece.values()
+    }
+    # ctx holds everything converters may need, while the module gets only
+    # the names its code refers to (naive values are referred to by quoted
+    # names, which are matched too)
+    used_names = set(
+        _name_pattern.findall(
+            "".join(
+                "".join(code_piece.code_parts)
+                for code_piece in code_storage.key_to_code_piece.values()
+            )
+        )
+    )
+
+    builder = ModuleBuilder(name)
+    naive_lines = []
+    for value_name, value in ctx["__naive_values__"].items():
+        if value_name not in used_names:
+            continue
+        code = builder.value_expr(value_name, value)
+        if code is not None:
+            naive_lines.append(f"    {value_name!r}: {code},")
+
+    global_lines = []
+    for global_name, value in ctx.items():
+        if (
+            global_name in _ctx_names_to_skip
+            or global_name in defined_names
+            or global_name not in used_names
+        ):
+            continue
+        import_ = gen_import(value)
+        if import_ is None:
+            builder.injections[global_name] = value
+            global_lines.append(
+                f"{global_name} = __naive_values__.pop({global_name!r})"
+            )
+        elif import_ == (global_name, ""):
+            builder.import_lines.append(f"import {global_name}")
+        elif import_[1] == global_name:
+            builder.import_lines.append(
+                f"from {import_[0]} import {global_name}"
+            )
+        else:
+            global_lines.append(
+                f"{global_name} = {builder.import_expr(*import_)}"
+            )
+
+    convtools_version = import_module("convtools").__version__
+    lines = [
+        f'"""Generated by convtools {convtools_version}, do not edit.',
+        "",
+        f"python: {sys.version.split()[0]}",
+        '"""',
+        "",
+        *(
+            ("from convtools._export import get_injections",)
+            if builder.injections
+            else ()
+        ),
+        *(
+            ("from convtools._utils import _none as __none__",)
+            if "__none__" in used_names
+            else ()
+        ),
+        *builder.import_lines,
+        "",
+        "",
+        "__convtools__code_storage = None",
+        "__exceptions_to_dump_sources = ()",
+        "__naive_values__ = {",
+        *naive_lines,
+        "}",
+    ]
+    if builder.injections:
+        lines.append(
+            "__naive_values__.update("
+            f"get_injections({name!r}, {tuple(builder.injections)!r}))"
+        )
+    lines.extend(global_lines)
+    lines.append("")
+    for code_piece in code_storage.key_to_code_piece.values():
+        lines.append("".join(code_piece.code_parts).strip("\n"))
+        lines.append("")
+
+    lines.append("")
+    for converter_name, generated_name in name_to_generated_name.items():
+        lines.append(f"{converter_name} = {generated_name}")
+    lines.append(f"__all__ = {list(name_to_generated_name)!r}")
+    source = "\n".join(lines) + "\n"
+
+    if path is not None:
+        with open(path, "w", encoding="utf-8") as f:
+            f.write(source)
+
+    return ExportedModule(source, builder.injections)
@@ -1,6 +1,11 @@
 """Helpers to collect info about environment."""
 
+import json
+import os
+import platform
 import sys
+from timeit import Timer
+from typing import Dict, Optional
 
 
 # generated by "python benchmarks/build_heuristics.py"
@@ -117,3 +122,150 @@ else:
         DICT_INIT = 815
         FUNCTION_CALL = DICT_LOOKUP * 4
         UNPREDICTABLE = 81500
+
+
+#: path to weights saved by ``calibrate_weights``, loaded on import
+WEIGHTS_FILE_ENV_VAR = "PY_CONVTOOLS_WEIGHTS_FILE"
+
+# statements (with setups) to measure weights, STEP is a loop iteration
+WEIGHT_BENCHMARKS = {
+    "LOGICAL": ("x or y", "x=0; y=1"),
+    "DICT_LOOKUP": ("d['abc']", "d = {'abc': 1}"),
+    "MATH_SIMPLE": ("x / y", "x=1;y=2"),
+    "ATTR_LOOKUP": ("A.b", "class A: b = 1"),
+    "TUPLE_INIT": ("(x,2,3,4,5)", "x=1"),
+    "LIST_INIT": ("[1,2,3,4,5]", "pass"),
+    "SET_INIT": ("{1,2,3,4,5}", "pass"),
+    "DICT_INIT": ("{'a': 1, 'b': 2, 'c': 3, 'd': 4, 'e': 5}", "pass"),
+    "FUNCTION_CALL": ("f(x)", "def f(x): return x\nx = 1"),
+}
+WEIGHT_NAMES = ("STEP", *WEIGHT_BENCHMARKS, "UNPREDICTABLE")
+
+#: path calibrated weights were loaded from, if any
+calibrated_weights_path: "Optional[str]" = None
+
+
+def get_environment() -> str:
+    """Describe the interpreter and the platform weights are measured on."""
+    return " ".join(
+        (
+            sys.implementation.name,
+            platform.python_version(),
+            platform.machine(),
+        )
+    )
+
+
+def measure_time(stmt, setup="pass", repeat=5, min_time=0.05) -> float:
+    """Return the best time of a single run of the statement."""
+    timer = Timer(stmt, setup)
+    number = 1
+    while True:
+        time_taken = timer.timeit(number)
+        if time_taken >= min_time:
+            break
+        number = max(
+            number * 2, int(number * min_time * 1.2 / max(time_taken, 1e-9))
+        )
+    return min(timer.repeat(repeat=repeat, number=number)) / number
+
+
+def weights_from_times(base_time, name_to_time) -> "Dict[str, int]":
+    """Convert times to weights, base_time being one hundredth of STEP."""
+    weights = {"STEP": 100}
+    for name, time_taken in name_to_time.items():
+        weights[name] = max(1, int(time_taken / base_time))
+    weights["UNPREDICTABLE"] = max(weights.values()) * 100
+    return weights
+
+
+def measure_weights(repeat=5, min_time=0.05) -> "Dict[str, int]":
+    """Measure weights on the current host.
+
+    It runs the statements of ``WEIGHT_BENCHMARKS`` and takes the best of
+    ``repeat`` runs of each, so it takes about ``2 * repeat * min_time``
+    seconds per weight.
+    """
+    base_time = (
+        measure_time("for i in r: pass", "r = range(1000)", repeat, min_time)
+        / 1000
+        / 100
+    )
+    return weights_from_times(
+        base_time,
+        {
+            name: measure_time(stmt, setup, repeat, min_time)
+            for name, (stmt, setup) in WEIGHT_BENCHMARKS.items()
+        },
+    )
+
+
+def save_weights(path, weights):
+    """Save weights to be loaded on import if the environment matches."""
+    dir_path = os.path.dirname(os.path.abspath(path))
+    os.makedirs(dir_path, exist_ok=True)
+    tmp_path = f"{path}.{os.getpid()}.tmp"
+    with open(tmp_path, "w", encoding="utf-8") as f:
+        json.dump(
+            {"environment": get_environment(), "weights": weights},
+            f,
+            indent=2,
+        )
+    os.replace(tmp_path, path)
+
+
+def load_weights(path) -> "Optional[Dict[str, int]]":
+    """Load saved weights, None if missing, invalid or measured elsewhere."""
+    try:
+        with open(path, encoding="utf-8") as f:
+            data = json.load(f)
+    except (OSError, ValueError):
+        return None
+    if not isinstance(data, dict) or data.get("environment") != (
+        get_environment()
+    ):
+        return None
+    weights = data.get("weights")
+    if (
+        not isinstance(weights, dict)
+        or set(weights) != set(WEIGHT_NAMES)
+        or not all(
+            type(value) is int and value > 0 for value in weights.values()
+        )
+    ):
+        return None
+    return weights
+
+
+def calibrate_weights(path=None, repeat=5, min_time=0.05) -> "Dict[str, int]":
+    """Measure weights on the current host and save them to a file.
+
+    The file defaults to ``PY_CONVTOOLS_WEIGHTS_FILE`` environment variable.
+    Weights are used when it points to the file at import time, so they take
+    effect in new processes.
+    """
+    path = path or os.environ.get(WEIGHTS_FILE_ENV_VAR)
+    if not path:
+        raise ValueError(
+            f"pass path or set {WEIGHTS_FILE_ENV_VAR} environment variable"
+        )
+    weights = measure_weights(repeat=repeat, min_time=min_time)
+    save_weights(path, weights)
+    return weights
+
+
+def load_calibrated_weights():
+    global calibrated_weights_path  # pylint: disable=global-statement
+
+    path = os.environ.get(WEIGHTS_FILE_ENV_VAR)
+    if not path:
+        return
+    weights = load_weights(path)
+    if weights is None:
+        return
+    for name, value in weights.items():
+        setattr(Weights, name, value)
+    calibrated_weights_path = path
+
+
+load_calibrated_weights()
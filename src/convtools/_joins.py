@@ -1,7 +1,8 @@
 """Join conversions."""
 
+from bisect import bisect_left, bisect_right
 from collections.abc import Sized
-from itertools import chain, repeat
+from itertools import accumulate, chain, repeat
 from typing import Set
 
 from ._aggregations import Aggregate, ReduceFuncs
@@ -12,10 +13,13 @@ from ._base import (
     Eq,
     EscapedString,
     If,
+    InlineExpr,
     LazyEscapedString,
     ListComp,
     NaiveConversion,
     Namespace,
+    Not,
+    Or,
     This,
     Tuple_,
 )
@@ -56,6 +60,13 @@ class _JoinConditions:
     LEFT_NAME = LEFT.name
     RIGHT_NAME = RIGHT.name
     _ANY = {LEFT_NAME, RIGHT_NAME}
+    RANGE_OPS = {
+        "{0} < {1}": "<",
+        "{0} <= {1}": "<=",
+        "{0} > {1}": ">",
+        "{0} >= {1}": ">=",
+    }
+    FLIPPED_RANGE_OPS = {"<": ">", "<=": ">=", ">": "<", ">=": "<="}
 
     def __init__(self, how="inner", swapped=False):
         if how == "right":
@@ -68,6 +79,9 @@ class _JoinConditions:
         self.left_row_hashers = []
         self.right_collection_filters = []
         self.right_row_hashers = []
+        # (comparison, right conversion, operator, left conversion) of
+        # comparisons, which are also among inner loop conditions
+        self.range_conditions = []
 
         self.how = how
         self.swapped = swapped
@@ -170,6 +184,7 @@ class _JoinConditions:
         deps_length = len(deps)
         if deps_length > 1:
             self.inner_loop_conditions.append(other)
+            self._add_range_condition(other)
         elif deps_length == 1:
             if self.LEFT_NAME in deps:
                 self._add_left_filter(other)
@@ -178,6 +193,26 @@ class _JoinConditions:
         else:
             self.pre_filter.append(other)
 
+    def _add_range_condition(self, conversion: BaseConversion):
+        if (
+            not isinstance(conversion, InlineExpr)
+            or conversion.code_str not in self.RANGE_OPS
+            or len(conversion.args) != 2
+            or conversion.kwargs
+        ):
+            return
+        op = self.RANGE_OPS[conversion.code_str]
+        first, second = conversion.args
+        left_deps = {self.RIGHT_NAME if self.swapped else self.LEFT_NAME}
+        right_deps = {self.LEFT_NAME if self.swapped else self.RIGHT_NAME}
+        first_deps, second_deps = map(self._get_join_deps, conversion.args)
+        if first_deps == right_deps and second_deps == left_deps:
+            self.range_conditions.append((first, op, second))
+        elif first_deps == left_deps and second_deps == right_deps:
+            self.range_conditions.append(
+                (second, self.FLIPPED_RANGE_OPS[op], first)
+            )
+
     def consume_and(self, and_conversion: And):
         if not isinstance(and_conversion, And):
             raise AssertionError
@@ -190,6 +225,27 @@ class _JoinConditions:
             else:
                 self.consume_other(arg)
 
+    def get_key_conversions(self):
+        """Return conversions of left & right rows to their join keys."""
+        return (
+            self.wrap_with_namespace(
+                (
+                    Tuple_(*self.left_row_hashers)
+                    if len(self.left_row_hashers) > 1
+                    else self.left_row_hashers[0]
+                ),
+                left=True,
+            ),
+            self.wrap_with_namespace(
+                (
+                    Tuple_(*self.right_row_hashers)
+                    if len(self.right_row_hashers) > 1
+                    else self.right_row_hashers[0]
+                ),
+                right=True,
+            ),
+        )
+
     def wrap_with_namespace(self, conversion, left=None, right=None):
         name_to_code = {}
         if left is not None:
@@ -214,6 +270,21 @@ class JoinConversion(BaseConversion):
         join
       how (str): one of the following: ``"inner"``, ``"left"``, ``"right"``,
         ``"outer"``
+      sorted (bool): both collections are sorted by keys of equality
+        conditions, so they are streamed and merged, keeping in memory only
+        right items of the current key (sort-merge join)
+      build (str): which collection of a hash join is loaded into a hash
+        table, the other one is streamed: ``"left"`` (a hint that it is the
+        smaller one), ``"right"`` or ``"auto"``: the one, which is sized and
+        smaller than the other or the other is not sized. Pairs follow the
+        order of items of the streamed collection, unmatched items of the
+        hashed one come last. By default the right one is hashed (the left
+        one for ``how="right"``).
+      bisect (bool): joins without equality conditions sort right items and
+        bisect them by comparisons of left and right expressions (range,
+        band and interval joins). Right expressions are evaluated for every
+        right item upfront and have to be totally ordered (e.g. no sets or
+        None), matching right items come in their sort order.
     """
 
     self_content_type = (
@@ -227,6 +298,9 @@ class JoinConversion(BaseConversion):
         right_conversion: BaseConversion,
         condition: BaseConversion,
         how="inner",
+        sorted=False,  # pylint: disable=redefined-builtin
+        build=None,
+        bisect=False,
     ):
         super().__init__()
         self.left_conversion = self.ensure_conversion(left_conversion)
@@ -244,6 +318,11 @@ class JoinConversion(BaseConversion):
             )
         )
         self.how = self.validate_how(how)
+        self.sorted = sorted
+        if build not in (None, "auto", "left", "right"):
+            raise ValueError("build must be one of: None, auto, left, right")
+        self.build = build
+        self.bisect = bisect
 
     @classmethod
     def validate_how(cls, how: str):
@@ -264,221 +343,725 @@ class JoinConversion(BaseConversion):
         code = Code()
         function_ctx = self.condition.as_function_ctx(ctx, optimize_naive=True)
 
-        if join_conditions.swapped:
-            function_ctx.add_arg("left_", self.right_conversion)
-            function_ctx.add_arg("right_", self.left_conversion)
-        else:
-            function_ctx.add_arg("left_", self.left_conversion)
-            function_ctx.add_arg("right_", self.right_conversion)
+        c_left = self.left_conversion
+        c_right = self.right_conversion
+        runtime_counters = ctx[self.RUNTIME_COUNTERS]
+        counters = None
+        if runtime_counters is not None:
+            counters = runtime_counters.add_stage(
+                "join", "left_rows", "right_rows", "rows_out"
+            )
+            c_left = NaiveConversion(counters["left_rows"].count_iter).call(
+                c_left
+            )
+            c_right = NaiveConversion(
+                counters["right_rows"].count_iter
+            ).call(c_right)
+            # internals of the join are reported as the join stage
+            ctx[self.RUNTIME_COUNTERS] = None
+
+        try:
+            if join_conditions.swapped:
+                function_ctx.add_arg("left_", c_right)
+                function_ctx.add_arg("right_", c_left)
+            else:
+                function_ctx.add_arg("left_", c_left)
+                function_ctx.add_arg("right_", c_right)
 
-        function_ctx.add_arg("_none", EscapedString("_none"))
+            function_ctx.add_arg("_none", EscapedString("_none"))
 
-        with function_ctx:
-            code.add_line("def placeholder", 1)
+            with function_ctx:
+                code.add_line("def placeholder", 1)
 
-            if join_conditions.left_collection_filters:
-                code.add_line(
-                    "left_ = %s"
-                    % This.filter(
-                        join_conditions.wrap_with_namespace(
-                            And(*join_conditions.left_collection_filters),
-                            left=True,
-                        )
-                    ).gen_code_and_update_ctx("left_", ctx),
+                if self.sorted:
+                    self.add_merge_join_lines(code, join_conditions, ctx)
+                else:
+                    self.add_loop_join_lines(code, join_conditions, ctx)
+
+                code.lines_info[0] = (
                     0,
+                    f"def {converter_name}({function_ctx.get_def_all_args_code()}):",
                 )
+                conversion = function_ctx.gen_conversion(
+                    converter_name, code.to_string(0)
+                )
+        finally:
+            ctx[self.RUNTIME_COUNTERS] = runtime_counters
+        c_result = function_ctx.call_with_all_args(conversion)
 
-            if join_conditions.outer_join:
-                code.add_line("yielded_right_ids = set()", 0)
-
-            def track_id():
-                if join_conditions.outer_join:
-                    code.add_line("yielded_right_ids.add(id(right_item))", 0)
-
-            if join_conditions.right_row_hashers:
-                c_left_key_to_hash = join_conditions.wrap_with_namespace(
-                    (
-                        Tuple_(*join_conditions.left_row_hashers)
-                        if len(join_conditions.left_row_hashers) > 1
-                        else join_conditions.left_row_hashers[0]
+        if join_conditions.pre_filter:
+            if join_conditions.inner_join:
+                c_result = If(
+                    And(*join_conditions.pre_filter),
+                    c_result,
+                    Tuple_().pipe(iter),
+                )
+            elif join_conditions.outer_join:
+                c_result = If(
+                    And(*join_conditions.pre_filter),
+                    c_result,
+                    CallFunc(
+                        chain,
+                        CallFunc(zip, self.left_conversion, repeat(None)),
+                        CallFunc(zip, repeat(None), self.right_conversion),
                     ),
-                    left=True,
                 )
-                c_right_key_to_hash = join_conditions.wrap_with_namespace(
+            else:
+                c_result = If(
+                    And(*join_conditions.pre_filter),
+                    c_result,
                     (
-                        Tuple_(*join_conditions.right_row_hashers)
-                        if len(join_conditions.right_row_hashers) > 1
-                        else join_conditions.right_row_hashers[0]
+                        CallFunc(zip, repeat(None), self.right_conversion)
+                        if join_conditions.swapped
+                        else CallFunc(zip, self.left_conversion, repeat(None))
                     ),
-                    right=True,
                 )
-                code.add_line(
-                    "hash_to_right_items = %s"
-                    % EscapedString("right_")
-                    .pipe(
-                        Aggregate(
-                            ReduceFuncs.DictArray(
-                                c_right_key_to_hash,
-                                This,
-                                default=NaiveConversion({}),
-                                where=(
-                                    join_conditions.wrap_with_namespace(
-                                        And(
-                                            *join_conditions.right_collection_filters
-                                        ),
-                                        right=True,
-                                    )
-                                    if join_conditions.right_collection_filters
-                                    else None
-                                ),
-                            )
-                        )
-                    )
-                    .gen_code_and_update_ctx("right_", ctx),
-                    0,
-                )
-                code.add_line("del right_", 0)
-                initial_right = "(item for items in hash_to_right_items.values() for item in items)"
 
-                code.add_line("for left_item in left_:", 1)
-                code.add_line(
-                    "left_key = %s"
-                    % c_left_key_to_hash.gen_code_and_update_ctx(
-                        "left_item", ctx
-                    ),
-                    0,
-                )
+        if counters is not None:
+            c_result = NaiveConversion(counters["rows_out"].count_iter).call(
+                c_result
+            )
+        return c_result.gen_code_and_update_ctx(code_input, ctx)
 
-                c_left_key = EscapedString("left_key")
-                c_hash_to_right_items = EscapedString("hash_to_right_items")
+    @staticmethod
+    def add_left_filter_lines(code, join_conditions, ctx):
+        if join_conditions.left_collection_filters:
+            code.add_line(
+                "left_ = %s"
+                % This.filter(
+                    join_conditions.wrap_with_namespace(
+                        And(*join_conditions.left_collection_filters),
+                        left=True,
+                    )
+                ).gen_code_and_update_ctx("left_", ctx),
+                0,
+            )
 
-                code.add_line(
-                    "right_items = %s"
-                    % If(
-                        c_left_key.in_(c_hash_to_right_items),
-                        c_hash_to_right_items.item(c_left_key).pipe(
-                            This.filter(
+    def add_loop_join_lines(self, code, join_conditions, ctx):
+        """Add lines of hash join or nested loop join."""
+        build = self.build
+        if join_conditions.swapped and build in ("left", "right"):
+            build = "left" if build == "right" else "right"
+        if join_conditions.right_row_hashers and build in ("left", "auto"):
+            self.add_left_build_lines(code, join_conditions, build, ctx)
+
+        self.add_left_filter_lines(code, join_conditions, ctx)
+        if join_conditions.outer_join:
+            code.add_line("yielded_right_ids = set()", 0)
+
+        if join_conditions.right_row_hashers:
+            c_left_key_to_hash, c_right_key_to_hash = (
+                join_conditions.get_key_conversions()
+            )
+            code.add_line(
+                "hash_to_right_items = %s"
+                % EscapedString("right_")
+                .pipe(
+                    Aggregate(
+                        ReduceFuncs.DictArray(
+                            c_right_key_to_hash,
+                            This,
+                            default=NaiveConversion({}),
+                            where=(
                                 join_conditions.wrap_with_namespace(
                                     And(
-                                        *join_conditions.inner_loop_conditions
+                                        *join_conditions.right_collection_filters
                                     ),
-                                    left="left_item",
                                     right=True,
                                 )
-                            )
-                            if join_conditions.inner_loop_conditions
-                            else This
-                        ),
-                        Tuple_(),
+                                if join_conditions.right_collection_filters
+                                else None
+                            ),
+                        )
                     )
-                    .pipe(iter if join_conditions.left_join else This)
-                    .gen_code_and_update_ctx(None, ctx),
-                    0,
                 )
+                .gen_code_and_update_ctx("right_", ctx),
+                0,
+            )
+            code.add_line("del right_", 0)
+            initial_right = "(item for items in hash_to_right_items.values() for item in items)"
+
+            code.add_line("for left_item in left_:", 1)
+            code.add_line(
+                "left_key = %s"
+                % c_left_key_to_hash.gen_code_and_update_ctx(
+                    "left_item", ctx
+                ),
+                0,
+            )
 
-            else:
-                if join_conditions.right_collection_filters:
-                    code.add_line(
-                        "right_ = %s"
-                        % ListComp(
-                            This,
-                            join_conditions.wrap_with_namespace(
-                                And(*join_conditions.right_collection_filters),
-                                right=True,
-                            ),
-                            _none,
-                        ).gen_code_and_update_ctx("right_", ctx),
-                        0,
-                    )
-                else:
-                    code.add_line(
-                        "right_ = %s"
-                        % If(
-                            CallFunc(isinstance, This, Sized),
-                            This,
-                            This.pipe(list),
-                        ).gen_code_and_update_ctx("right_", ctx),
-                        0,
-                    )
-                initial_right = "right_"
+            c_left_key = EscapedString("left_key")
+            c_hash_to_right_items = EscapedString("hash_to_right_items")
 
-                code.add_line("for left_item in left_:", 1)
-                code.add_line(
-                    "right_items = %s"
-                    % (
+            code.add_line(
+                "right_items = %s"
+                % If(
+                    c_left_key.in_(c_hash_to_right_items),
+                    c_hash_to_right_items.item(c_left_key).pipe(
                         This.filter(
-                            Namespace(
-                                And(*join_conditions.inner_loop_conditions),
-                                name_to_code={
-                                    _JoinConditions.LEFT_NAME: "left_item",
-                                    _JoinConditions.RIGHT_NAME: True,
-                                },
+                            join_conditions.wrap_with_namespace(
+                                And(
+                                    *join_conditions.inner_loop_conditions
+                                ),
+                                left="left_item",
+                                right=True,
                             )
                         )
                         if join_conditions.inner_loop_conditions
                         else This
-                    )
-                    .pipe(iter if join_conditions.left_join else This)
-                    .gen_code_and_update_ctx("right_", ctx),
-                    0,
+                    ),
+                    Tuple_(),
                 )
+                .pipe(iter if join_conditions.left_join else This)
+                .gen_code_and_update_ctx(None, ctx),
+                0,
+            )
 
-            if join_conditions.left_join:
-                code.add_line("right_item = next(right_items, _none)", 0)
-                code.add_line("if right_item is _none:", 1)
+        else:
+            if join_conditions.right_collection_filters:
                 code.add_line(
-                    (
-                        "yield None, left_item"
-                        if join_conditions.swapped
-                        else "yield left_item, None"
-                    ),
-                    -1,
+                    "right_ = %s"
+                    % ListComp(
+                        This,
+                        join_conditions.wrap_with_namespace(
+                            And(*join_conditions.right_collection_filters),
+                            right=True,
+                        ),
+                        _none,
+                    ).gen_code_and_update_ctx("right_", ctx),
+                    0,
                 )
-                code.add_line("else:", 1)
-                track_id()
+            else:
                 code.add_line(
-                    (
-                        "yield right_item, left_item"
-                        if join_conditions.swapped
-                        else "yield left_item, right_item"
-                    ),
+                    "right_ = %s"
+                    % If(
+                        CallFunc(isinstance, This, Sized),
+                        This,
+                        This.pipe(list),
+                    ).gen_code_and_update_ctx("right_", ctx),
                     0,
                 )
-                code.add_line(
-                    "for right_item in right_items:",
-                    1,
+            initial_right = "right_"
+
+            range_conditions = self.get_range_conditions(join_conditions)
+            if range_conditions:
+                c_right_items = self.add_range_lookup_lines(
+                    code, join_conditions, range_conditions, ctx
                 )
-                track_id()
-                code.add_line(
-                    (
-                        "yield right_item, left_item"
-                        if join_conditions.swapped
-                        else "yield left_item, right_item"
-                    ),
-                    -3,
+            else:
+                code.add_line("for left_item in left_:", 1)
+                c_right_items = EscapedString("right_")
+            code.add_line(
+                "right_items = %s"
+                % c_right_items.pipe(
+                    This.filter(
+                        join_conditions.wrap_with_namespace(
+                            And(*join_conditions.inner_loop_conditions),
+                            left="left_item",
+                            right=True,
+                        )
+                    )
+                    if join_conditions.inner_loop_conditions
+                    else This
                 )
+                .pipe(iter if join_conditions.left_join else This)
+                .gen_code_and_update_ctx(None, ctx),
+                0,
+            )
+
+        self.add_yield_lines(code, join_conditions)
+
+        if join_conditions.outer_join:
+            code.add_line(
+                "yield from ("
+                "(None, right_item) "
+                f"for right_item in {initial_right} "
+                "if id(right_item) not in yielded_right_ids)",
+                0,
+            )
+
+    def get_range_conditions(self, join_conditions):
+        if not self.bisect:
+            return []
+        return join_conditions.range_conditions
+
+    @staticmethod
+    def add_range_lookup_lines(code, join_conditions, range_conditions, ctx):
+        """Add lines, which sort right items and start the left loop.
+
+        Right items are sorted by the right side of the first comparison, so
+        its bounds are found by bisecting sorted keys. Bounds of other right
+        expressions are found by bisecting their running max (lower bounds)
+        and running min from the end (upper bounds), which are
+        non-decreasing. Returns the conversion of candidate right items.
+        """
+        code_to_index = {}
+        for c_right, _, _ in range_conditions:
+            code_to_index.setdefault(
+                join_conditions.wrap_with_namespace(
+                    c_right, right=True
+                ).gen_code_and_update_ctx("right_item", ctx),
+                len(code_to_index),
+            )
+        right_codes = list(code_to_index)
+        code.add_line(
+            "sorted_right = sorted(right_, key=lambda right_item: "
+            f"{right_codes[0]})",
+            0,
+        )
+        code.add_line(
+            f"range_keys = [{right_codes[0]} for right_item in sorted_right]",
+            0,
+        )
 
+        bisect_left_code = NaiveConversion(
+            bisect_left
+        ).gen_code_and_update_ctx(None, ctx)
+        bisect_right_code = NaiveConversion(
+            bisect_right
+        ).gen_code_and_update_ctx(None, ctx)
+        accumulate_code = NaiveConversion(
+            accumulate
+        ).gen_code_and_update_ctx(None, ctx)
+        lower_bounds = []
+        upper_bounds = []
+        bounded_lists = set()
+        for c_right, op, c_left in range_conditions:
+            index = code_to_index[
+                join_conditions.wrap_with_namespace(
+                    c_right, right=True
+                ).gen_code_and_update_ctx("right_item", ctx)
+            ]
+            is_lower = op in (">", ">=")
+            if index == 0:
+                list_name = "range_keys"
             else:
-                code.add_line("for right_item in right_items:", 1)
-                track_id()
-                code.add_line(
-                    (
-                        "yield right_item, left_item"
-                        if join_conditions.swapped
-                        else "yield left_item, right_item"
+                list_name = f"range_{'maxes' if is_lower else 'mins'}_{index}"
+            if index and list_name not in bounded_lists:
+                bounded_lists.add(list_name)
+                if is_lower:
+                    code.add_line(
+                        f"{list_name} = list({accumulate_code}(("
+                        f"{right_codes[index]} for right_item in "
+                        "sorted_right), max))",
+                        0,
+                    )
+                else:
+                    code.add_line(
+                        f"{list_name} = list({accumulate_code}(("
+                        f"{right_codes[index]} for right_item in "
+                        "reversed(sorted_right)), min))",
+                        0,
+                    )
+                    code.add_line(f"{list_name}.reverse()", 0)
+
+            bisect_code = (
+                bisect_right_code if op in (">", "<=") else bisect_left_code
+            )
+            left_code = join_conditions.wrap_with_namespace(
+                c_left, left=True
+            ).gen_code_and_update_ctx("left_item", ctx)
+            (lower_bounds if is_lower else upper_bounds).append(
+                f"{bisect_code}({list_name}, {left_code})"
+            )
+
+        code.add_line("for left_item in left_:", 1)
+        if len(lower_bounds) > 1:
+            lower_code = f"max({', '.join(lower_bounds)})"
+        else:
+            lower_code = lower_bounds[0] if lower_bounds else ""
+        if len(upper_bounds) > 1:
+            upper_code = f"min({', '.join(upper_bounds)})"
+        else:
+            upper_code = upper_bounds[0] if upper_bounds else ""
+        # left expressions are not evaluated if there are no right items
+        return EscapedString(
+            f"(sorted_right[{lower_code}:{upper_code}] if sorted_right "
+            "else sorted_right)"
+        )
+
+    @staticmethod
+    def add_left_build_lines(code, join_conditions, build, ctx):
+        """Add lines of hash join, which hashes left items.
+
+        Right items are streamed, so pairs come in the order of right
+        items, followed by unmatched left ones. With ``build="auto"`` it
+        happens only if the left collection is sized and the right one is
+        either not or is larger.
+        """
+        if build == "auto":
+            c_sized = NaiveConversion(Sized)
+            code.add_line(
+                "if %s:"
+                % And(
+                    CallFunc(isinstance, EscapedString("left_"), c_sized),
+                    Or(
+                        Not(
+                            CallFunc(
+                                isinstance, EscapedString("right_"), c_sized
+                            )
+                        ),
+                        CallFunc(len, EscapedString("left_"))
+                        < CallFunc(len, EscapedString("right_")),
                     ),
-                    -2,
+                ).gen_code_and_update_ctx(None, ctx),
+                1,
+            )
+
+        c_left_key, c_right_key = join_conditions.get_key_conversions()
+        if join_conditions.left_join:
+            # left filters are among inner loop conditions
+            code.add_line("left_ = list(left_)", 0)
+            code.add_line("matched_left_ids = set()", 0)
+        code.add_line(
+            "hash_to_left_items = %s"
+            % EscapedString("left_")
+            .pipe(
+                Aggregate(
+                    ReduceFuncs.DictArray(
+                        c_left_key,
+                        This,
+                        default=NaiveConversion({}),
+                        where=(
+                            join_conditions.wrap_with_namespace(
+                                And(*join_conditions.left_collection_filters),
+                                left=True,
+                            )
+                            if join_conditions.left_collection_filters
+                            else None
+                        ),
+                    )
                 )
+            )
+            .gen_code_and_update_ctx("left_", ctx),
+            0,
+        )
+        if join_conditions.right_collection_filters:
+            code.add_line(
+                "right_ = %s"
+                % This.filter(
+                    join_conditions.wrap_with_namespace(
+                        And(*join_conditions.right_collection_filters),
+                        right=True,
+                    )
+                ).gen_code_and_update_ctx("right_", ctx),
+                0,
+            )
 
+        code.add_line("for right_item in right_:", 1)
+        code.add_line(
+            "right_key = %s"
+            % c_right_key.gen_code_and_update_ctx("right_item", ctx),
+            0,
+        )
+        c_right_key = EscapedString("right_key")
+        c_hash_to_left_items = EscapedString("hash_to_left_items")
+        code.add_line(
+            "left_items = %s"
+            % If(
+                c_right_key.in_(c_hash_to_left_items),
+                c_hash_to_left_items.item(c_right_key).pipe(
+                    This.filter(
+                        join_conditions.wrap_with_namespace(
+                            And(*join_conditions.inner_loop_conditions),
+                            left=True,
+                            right="right_item",
+                        )
+                    )
+                    if join_conditions.inner_loop_conditions
+                    else This
+                ),
+                Tuple_(),
+            )
+            .pipe(iter if join_conditions.outer_join else This)
+            .gen_code_and_update_ctx(None, ctx),
+            0,
+        )
+        pair_code = (
+            "right_item, left_item"
+            if join_conditions.swapped
+            else "left_item, right_item"
+        )
+        if join_conditions.outer_join:
+            code.add_line("left_item = next(left_items, _none)", 0)
+            code.add_line("if left_item is _none:", 1)
+            code.add_line("yield None, right_item", -1)
+            code.add_line("else:", 1)
+            code.add_line("matched_left_ids.add(id(left_item))", 0)
+            code.add_line(f"yield {pair_code}", 0)
+        code.add_line("for left_item in left_items:", 1)
+        if join_conditions.left_join:
+            code.add_line("matched_left_ids.add(id(left_item))", 0)
+        code.add_line(
+            f"yield {pair_code}", -3 if join_conditions.outer_join else -2
+        )
+
+        if join_conditions.left_join:
+            code.add_line("for left_item in left_:", 1)
+            code.add_line("if id(left_item) not in matched_left_ids:", 1)
+            code.add_line(
+                (
+                    "yield None, left_item"
+                    if join_conditions.swapped
+                    else "yield left_item, None"
+                ),
+                -2,
+            )
+        if build == "auto":
+            code.add_line("return", -1)
+        else:
+            code.add_line("return", 0)
+
+    def add_merge_join_lines(self, code, join_conditions, ctx):
+        """Add lines of sort-merge join.
+
+        Right items are read one ahead (head_item): ones of the current key
+        are collected to a run, ones of lesser keys are skipped (or yielded
+        unmatched for outer joins). Keys are checked to be non-decreasing.
+        """
+        if not join_conditions.right_row_hashers:
+            raise ValueError(
+                "sorted join requires equality conditions on keys"
+            )
+        c_left_key, c_right_key = join_conditions.get_key_conversions()
+
+        self.add_left_filter_lines(code, join_conditions, ctx)
+        if join_conditions.right_collection_filters:
+            code.add_line(
+                "right_ = %s"
+                % This.filter(
+                    join_conditions.wrap_with_namespace(
+                        And(*join_conditions.right_collection_filters),
+                        right=True,
+                    )
+                ).gen_code_and_update_ctx("right_", ctx),
+                0,
+            )
+        head_key_code = c_right_key.gen_code_and_update_ctx(
+            "head_item", ctx
+        )
+
+        def add_next_head_lines():
+            code.add_line("head_item = next(right_, _none)", 0)
+            code.add_line("if head_item is not _none:", 1)
+            code.add_line(f"next_head_key = {head_key_code}", 0)
+            code.add_line("if next_head_key < head_key:", 1)
+            code.add_line(
+                'raise ValueError("right input is not sorted by join keys")',
+                -1,
+            )
+            code.add_line("head_key = next_head_key", -1)
+
+        def add_unmatched_run_lines():
             if join_conditions.outer_join:
+                code.add_line("for right_item in run:", 1)
                 code.add_line(
-                    "yield from ("
-                    "(None, right_item) "
-                    f"for right_item in {initial_right} "
-                    "if id(right_item) not in yielded_right_ids)",
-                    0,
+                    "if id(right_item) not in yielded_right_ids:", 1
                 )
+                code.add_line("yield None, right_item", -2)
+
+        code.add_line("right_ = iter(right_)", 0)
+        code.add_line("head_item = next(right_, _none)", 0)
+        code.add_line("if head_item is not _none:", 1)
+        code.add_line(f"head_key = {head_key_code}", -1)
+        code.add_line("run_key = _none", 0)
+        code.add_line("run = ()", 0)
+
+        code.add_line("for left_item in left_:", 1)
+        code.add_line(
+            "left_key = %s"
+            % c_left_key.gen_code_and_update_ctx("left_item", ctx),
+            0,
+        )
+        code.add_line("if run_key is _none or left_key != run_key:", 1)
+        code.add_line("if run_key is not _none and left_key < run_key:", 1)
+        code.add_line(
+            'raise ValueError("left input is not sorted by join keys")', -1
+        )
+        add_unmatched_run_lines()
+        code.add_line(
+            "while head_item is not _none and head_key < left_key:", 1
+        )
+        if join_conditions.outer_join:
+            code.add_line("yield None, head_item", 0)
+        add_next_head_lines()
+        code.incr_indent_level(-1)
+        code.add_line("run = []", 0)
+        code.add_line(
+            "while head_item is not _none and head_key == left_key:", 1
+        )
+        code.add_line("run.append(head_item)", 0)
+        add_next_head_lines()
+        code.incr_indent_level(-1)
+        code.add_line("run_key = left_key", 0)
+        if join_conditions.outer_join:
+            code.add_line("yielded_right_ids = set()", 0)
+        code.incr_indent_level(-1)
+
+        code.add_line(
+            "right_items = %s"
+            % (
+                This.filter(
+                    join_conditions.wrap_with_namespace(
+                        And(*join_conditions.inner_loop_conditions),
+                        left="left_item",
+                        right=True,
+                    )
+                )
+                if join_conditions.inner_loop_conditions
+                else This
+            )
+            .pipe(iter if join_conditions.left_join else This)
+            .gen_code_and_update_ctx("run", ctx),
+            0,
+        )
+        self.add_yield_lines(code, join_conditions)
+
+        add_unmatched_run_lines()
+        if join_conditions.outer_join:
+            code.add_line("while head_item is not _none:", 1)
+            code.add_line("yield None, head_item", 0)
+            add_next_head_lines()
+            code.incr_indent_level(-1)
+
+    @staticmethod
+    def add_track_id_line(code, join_conditions):
+        if join_conditions.outer_join:
+            code.add_line("yielded_right_ids.add(id(right_item))", 0)
+
+    def add_yield_lines(self, code, join_conditions):
+        """Add lines, which yield pairs of left_item and right_items."""
+        if join_conditions.left_join:
+            code.add_line("right_item = next(right_items, _none)", 0)
+            code.add_line("if right_item is _none:", 1)
+            code.add_line(
+                (
+                    "yield None, left_item"
+                    if join_conditions.swapped
+                    else "yield left_item, None"
+                ),
+                -1,
+            )
+            code.add_line("else:", 1)
+            self.add_track_id_line(code, join_conditions)
+            code.add_line(
+                (
+                    "yield right_item, left_item"
+                    if join_conditions.swapped
+                    else "yield left_item, right_item"
+                ),
+                0,
+            )
+            code.add_line(
+                "for right_item in right_items:",
+                1,
+            )
+            self.add_track_id_line(code, join_conditions)
+            code.add_line(
+                (
+                    "yield right_item, left_item"
+                    if join_conditions.swapped
+                    else "yield left_item, right_item"
+                ),
+                -3,
+            )
+
+        else:
+            code.add_line("for right_item in right_items:", 1)
+            self.add_track_id_line(code, join_conditions)
+            code.add_line(
+                (
+                    "yield right_item, left_item"
+                    if join_conditions.swapped
+                    else "yield left_item, right_item"
+                ),
+                -2,
+            )
+
+
+class AsofJoinConversion(BaseConversion):
+    """Join each left item to the nearest right one by ``on`` (as-of join).
+
+    Both collections are to be sorted by ``on`` values. Results are
+    ``(left_item, right_item)`` pairs in the order of left items, where
+    ``right_item`` is ``None`` if there is no match (like in left joins).
 
+    Args:
+      left_conversion (BaseConversion): left collection to join
+      right_conversion (BaseConversion): right collection to join
+      on: conversion of an item to its sort value (e.g. time) or a tuple of
+        two conversions: for left and right items
+      by: optional conversion (or a tuple of two) of an item to its
+        partition key: only items of equal keys are matched
+      direction (str): ``"backward"`` matches the last right item with
+        ``on`` value <= the left one, ``"forward"``: the first one with
+        ``on`` value >= the left one, ``"nearest"``: the closest one (exact
+        matches win, otherwise ties go to the preceding one)
+      tolerance: max distance between matched ``on`` values
+    """
+
+    self_content_type = (
+        BaseConversion.self_content_type
+        | BaseConversion.ContentTypes.NONE_USAGE
+    )
+
+    def __init__(
+        self,
+        left_conversion: BaseConversion,
+        right_conversion: BaseConversion,
+        on,
+        by=None,
+        direction="backward",
+        tolerance=None,
+    ):
+        super().__init__()
+        self.left_conversion = self.ensure_conversion(left_conversion)
+        self.right_conversion = self.ensure_conversion(right_conversion)
+        self.left_on, self.right_on = self.to_pair(on)
+        self.left_by, self.right_by = (
+            (None, None) if by is None else self.to_pair(by)
+        )
+        if direction not in ("backward", "forward", "nearest"):
+            raise ValueError(
+                "direction must be one of: backward, forward, nearest"
+            )
+        self.direction = direction
+        self.tolerance = (
+            None if tolerance is None else self.ensure_conversion(tolerance)
+        )
+
+    def to_pair(self, conversions):
+        if isinstance(conversions, tuple):
+            if len(conversions) != 2:
+                raise ValueError(
+                    "expected a conversion or a tuple of left and right ones"
+                )
+            return tuple(map(self.ensure_conversion, conversions))
+        conversion = self.ensure_conversion(conversions)
+        return conversion, conversion
+
+    def _gen_code_and_update_ctx(self, code_input, ctx):
+        suffix = self.gen_random_name("", ctx)
+        converter_name = f"asof_join{suffix}"
+        code = Code()
+        keys = [self.left_on, self.right_on]
+        if self.left_by is not None:
+            keys.extend((self.left_by, self.right_by))
+        if self.tolerance is not None:
+            keys.append(self.tolerance)
+        function_ctx = Tuple_(*keys).as_function_ctx(
+            ctx, optimize_naive=True
+        )
+        function_ctx.add_arg("left_", self.left_conversion)
+        function_ctx.add_arg("right_", self.right_conversion)
+        function_ctx.add_arg("_none", EscapedString("_none"))
+
+        with function_ctx:
+            code.add_line("def placeholder", 1)
+            if self.direction == "backward":
+                self.add_backward_lines(code, ctx)
+            else:
+                self.add_lookup_lines(code, ctx)
             code.lines_info[0] = (
                 0,
                 f"def {converter_name}({function_ctx.get_def_all_args_code()}):",
@@ -486,34 +1069,163 @@ class JoinConversion(BaseConversion):
             conversion = function_ctx.gen_conversion(
                 converter_name, code.to_string(0)
             )
-        c_result = function_ctx.call_with_all_args(conversion)
+        return function_ctx.call_with_all_args(
+            conversion
+        ).gen_code_and_update_ctx(code_input, ctx)
+
+    def add_left_on_lines(self, code, ctx):
+        code.add_line("for left_item in left_:", 1)
+        code.add_line(
+            "next_left_on = %s"
+            % self.left_on.gen_code_and_update_ctx("left_item", ctx),
+            0,
+        )
+        code.add_line(
+            "if left_on is not _none and next_left_on < left_on:", 1
+        )
+        code.add_line(
+            'raise ValueError("left input is not sorted by on")', -1
+        )
+        code.add_line("left_on = next_left_on", 0)
+
+    def add_tolerance_lines(self, code, ctx, distance_code):
+        if self.tolerance is not None:
+            code.add_line(
+                "if right_item is not _none and %s > %s:"
+                % (
+                    distance_code,
+                    self.tolerance.gen_code_and_update_ctx(None, ctx),
+                ),
+                1,
+            )
+            code.add_line("right_item = _none", -1)
+        code.add_line(
+            "yield left_item, (None if right_item is _none else right_item)",
+            0,
+        )
 
-        if join_conditions.pre_filter:
-            if join_conditions.inner_join:
-                c_result = If(
-                    And(*join_conditions.pre_filter),
-                    c_result,
-                    Tuple_().pipe(iter),
-                )
-            elif join_conditions.outer_join:
-                c_result = If(
-                    And(*join_conditions.pre_filter),
-                    c_result,
-                    CallFunc(
-                        chain,
-                        CallFunc(zip, self.left_conversion, repeat(None)),
-                        CallFunc(zip, repeat(None), self.right_conversion),
-                    ),
-                )
-            else:
-                c_result = If(
-                    And(*join_conditions.pre_filter),
-                    c_result,
-                    (
-                        CallFunc(zip, repeat(None), self.right_conversion)
-                        if join_conditions.swapped
-                        else CallFunc(zip, self.left_conversion, repeat(None))
-                    ),
-                )
+    def add_backward_lines(self, code, ctx):
+        """Add lines, which stream both collections.
+
+        Right items are read while their ``on`` values are <= the left one,
+        the last read one of each partition is the match.
+        """
+        head_on_code = self.right_on.gen_code_and_update_ctx("head_item", ctx)
+        code.add_line("right_ = iter(right_)", 0)
+        code.add_line("head_item = next(right_, _none)", 0)
+        code.add_line("if head_item is not _none:", 1)
+        code.add_line(f"head_on = {head_on_code}", -1)
+        if self.left_by is None:
+            code.add_line("last_right_item = _none", 0)
+        else:
+            code.add_line("last_right_items = {}", 0)
+        code.add_line("left_on = _none", 0)
 
-        return c_result.gen_code_and_update_ctx(code_input, ctx)
+        self.add_left_on_lines(code, ctx)
+        code.add_line(
+            "while head_item is not _none and head_on <= left_on:", 1
+        )
+        if self.left_by is None:
+            code.add_line("last_right_item = head_item", 0)
+        else:
+            code.add_line(
+                "last_right_items[%s] = head_item"
+                % self.right_by.gen_code_and_update_ctx("head_item", ctx),
+                0,
+            )
+        code.add_line("head_item = next(right_, _none)", 0)
+        code.add_line("if head_item is not _none:", 1)
+        code.add_line(f"next_head_on = {head_on_code}", 0)
+        code.add_line("if next_head_on < head_on:", 1)
+        code.add_line(
+            'raise ValueError("right input is not sorted by on")', -1
+        )
+        code.add_line("head_on = next_head_on", -2)
+
+        if self.left_by is None:
+            code.add_line("right_item = last_right_item", 0)
+        else:
+            code.add_line(
+                "right_item = last_right_items.get(%s, _none)"
+                % self.left_by.gen_code_and_update_ctx("left_item", ctx),
+                0,
+            )
+        self.add_tolerance_lines(
+            code,
+            ctx,
+            "left_on - %s"
+            % self.right_on.gen_code_and_update_ctx("right_item", ctx),
+        )
+
+    def add_lookup_lines(self, code, ctx):
+        """Add lines of forward and nearest joins.
+
+        Right ``on`` values and items are collected to lists by partition
+        keys. Each partition keeps an index of its first ``on`` value >= the
+        current left one, which only moves forward, because left items are
+        sorted too.
+        """
+        right_on_code = self.right_on.gen_code_and_update_ctx(
+            "right_item", ctx
+        )
+        code.add_line("right_on = _none", 0)
+        if self.left_by is None:
+            code.add_line("partition = [[], [], 0]", 0)
+        else:
+            code.add_line("partitions = {}", 0)
+        code.add_line("for right_item in right_:", 1)
+        code.add_line(f"next_right_on = {right_on_code}", 0)
+        code.add_line(
+            "if right_on is not _none and next_right_on < right_on:", 1
+        )
+        code.add_line(
+            'raise ValueError("right input is not sorted by on")', -1
+        )
+        code.add_line("right_on = next_right_on", 0)
+        if self.left_by is not None:
+            code.add_line(
+                "right_key = %s"
+                % self.right_by.gen_code_and_update_ctx("right_item", ctx),
+                0,
+            )
+            code.add_line("if right_key in partitions:", 1)
+            code.add_line("partition = partitions[right_key]", -1)
+            code.add_line("else:", 1)
+            code.add_line(
+                "partition = partitions[right_key] = [[], [], 0]", -1
+            )
+        code.add_line("partition[0].append(right_on)", 0)
+        code.add_line("partition[1].append(right_item)", -1)
+
+        code.add_line("left_on = _none", 0)
+        self.add_left_on_lines(code, ctx)
+        if self.left_by is not None:
+            code.add_line(
+                "partition = partitions.get(%s)"
+                % self.left_by.gen_code_and_update_ctx("left_item", ctx),
+                0,
+            )
+            code.add_line("if partition is None:", 1)
+            code.add_line("yield left_item, None", 0)
+            code.add_line("continue", -1)
+        code.add_line("ons, items, index = partition", 0)
+        code.add_line(
+            "while index < len(ons) and ons[index] < left_on:", 1
+        )
+        code.add_line("index += 1", -1)
+        code.add_line("partition[2] = index", 0)
+
+        code.add_line("if index < len(ons):", 1)
+        code.add_line("right_item = items[index]", 0)
+        code.add_line("distance = ons[index] - left_on", -1)
+        code.add_line("else:", 1)
+        code.add_line("right_item = _none", -1)
+        if self.direction == "nearest":
+            code.add_line(
+                "if index and (right_item is _none or "
+                "left_on - ons[index - 1] <= distance):",
+                1,
+            )
+            code.add_line("right_item = items[index - 1]", 0)
+            code.add_line("distance = left_on - ons[index - 1]", -1)
+        self.add_tolerance_lines(code, ctx, "distance")
@@ -0,0 +1,310 @@
+"""Compact probabilistic summaries, which back approximate reducers."""
+
+from bisect import bisect_left
+from heapq import nlargest
+from itertools import accumulate, count
+from math import log, sqrt
+
+
+M64 = (1 << 64) - 1
+ALPHA_INF = 0.5 / log(2)
+
+
+def sigma(x: float) -> float:
+    """Correct the contribution of empty registers (0 <= x <= 1)."""
+    if x == 1:
+        return float("inf")
+    y = 1.0
+    z = x
+    while True:
+        x *= x
+        previous_z = z
+        z += x * y
+        y += y
+        if z == previous_z:
+            return z
+
+
+def tau(x: float) -> float:
+    """Correct the contribution of saturated registers (0 <= x <= 1)."""
+    if x in (0, 1):
+        return 0.0
+    y = 1.0
+    z = 1 - x
+    while True:
+        x = sqrt(x)
+        previous_z = z
+        y *= 0.5
+        z -= (1 - x) ** 2 * y
+        if z == previous_z:
+            return z / 3
+
+
+def hash64(value) -> int:
+    """Spread ``hash(value)`` across 64 bits (splitmix64 finalizer).
+
+    Builtin hashes of small ints are ints themselves, so they are mixed to
+    make every bit depend on every input bit.
+    """
+    h = hash(value) & M64
+    h = ((h ^ (h >> 30)) * 0xBF58476D1CE4E5B9) & M64
+    h = ((h ^ (h >> 27)) * 0x94D049BB133111EB) & M64
+    return h ^ (h >> 31)
+
+
+class HyperLogLog:
+    """Estimate the number of distinct values in ``2 ** precision`` bytes.
+
+    Each value is hashed to 64 bits: the top ``precision`` bits pick a
+    register, which keeps the max position of the leftmost 1-bit of the
+    rest. The relative standard error is ``1.04 / sqrt(2 ** precision)``.
+
+    Registers are built from :func:`hash`, so merged sketches are to come
+    from processes with the same ``PYTHONHASHSEED`` (strings and bytes are
+    salted per process).
+    """
+
+    __slots__ = ("precision", "shift", "mask", "registers")
+
+    min_precision = 4
+    max_precision = 16
+
+    def __init__(self, precision: int):
+        if (
+            not isinstance(precision, int)
+            or not self.min_precision <= precision <= self.max_precision
+        ):
+            raise ValueError(
+                f"precision must be an int from {self.min_precision} "
+                f"to {self.max_precision}"
+            )
+        self.precision = precision
+        self.shift = 64 - precision
+        self.mask = (1 << self.shift) - 1
+        self.registers = bytearray(1 << precision)
+
+    @staticmethod
+    def error_bound(precision: int) -> float:
+        """Return the relative standard error of estimates."""
+        return 1.04 / (1 << precision) ** 0.5
+
+    def add(self, value):
+        h = hash64(value)
+        index = h >> self.shift
+        rank = self.shift - (h & self.mask).bit_length() + 1
+        if rank > self.registers[index]:
+            self.registers[index] = rank
+
+    def merge(self, other: "HyperLogLog"):
+        if other.precision != self.precision:
+            raise ValueError("cannot merge sketches of different precision")
+        self.registers = bytearray(map(max, self.registers, other.registers))
+
+    def count(self) -> int:
+        """Estimate the count with the improved raw estimator by O. Ertl.
+
+        Unlike switching from linear counting to the raw HyperLogLog
+        estimate, it is nearly unbiased across all cardinalities, so there
+        is no worse error band around ``2.5 * m``.
+        """
+        registers = self.registers
+        m = len(registers)
+        q = self.shift
+        # registers take few distinct values, so they are counted in C
+        histogram = {rank: registers.count(rank) for rank in set(registers)}
+        z = m * tau(1 - histogram.get(q + 1, 0) / m)
+        for rank in range(q, 0, -1):
+            z = 0.5 * (z + histogram.get(rank, 0))
+        z += m * sigma(histogram.get(0, 0) / m)
+        return int(round(ALPHA_INF * m * m / z))
+
+
+class KLL:
+    """Estimate quantiles keeping ``O(k)`` values (KLL sketch).
+
+    Values are appended to the level 0 compactor. Once the sketch is full,
+    the lowest level over its capacity is sorted and every other value is
+    promoted to the next level, where each value stands for twice as many
+    inputs. Capacities shrink by 2/3 from the top level (``k``) down, so the
+    sketch keeps ~``3 * k`` values. Normalized rank error is ~``2 / k`` (~1%
+    for the default ``k`` of 200, see ``benchmarks/approx_percentile.py``).
+
+    Offsets of promoted values alternate instead of being random, so results
+    are reproducible.
+    """
+
+    __slots__ = (
+        "k",
+        "compactors",
+        "capacities",
+        "size",
+        "max_size",
+        "n",
+        "flips",
+        "cache",
+    )
+
+    min_k = 8
+    min_capacity = 8
+    ratio = 2 / 3
+
+    def __init__(self, k: int):
+        if not isinstance(k, int) or k < self.min_k:
+            raise ValueError(f"k must be an int, which is >= {self.min_k}")
+        self.k = k
+        self.compactors = [[]]
+        self.capacities = [k]
+        self.size = 0
+        self.max_size = k
+        self.n = 0
+        self.flips = 0
+        # (n, sorted values, last ranks covered by them)
+        self.cache = None
+
+    def grow(self):
+        self.compactors.append([])
+        height = len(self.compactors)
+        self.capacities = [
+            max(
+                self.min_capacity,
+                int(self.k * self.ratio ** (height - level - 1)),
+            )
+            for level in range(height)
+        ]
+        self.max_size = sum(self.capacities)
+
+    def add(self, value):
+        self.compactors[0].append(value)
+        self.n += 1
+        self.size += 1
+        if self.size >= self.max_size:
+            self.compress()
+
+    def compress(self):
+        """Compact levels over capacity until the sketch is not full."""
+        for level, compactor in enumerate(self.compactors):
+            if len(compactor) >= self.capacities[level]:
+                if level + 1 == len(self.compactors):
+                    self.grow()
+                compactor.sort()
+                # an odd value out stays
+                start = len(compactor) % 2
+                self.flips += 1
+                self.compactors[level + 1].extend(
+                    compactor[start + (self.flips & 1) :: 2]
+                )
+                del compactor[start:]
+                self.size = sum(map(len, self.compactors))
+                if self.size < self.max_size:
+                    break
+
+    def merge(self, other: "KLL"):
+        if other.k != self.k:
+            raise ValueError("cannot merge sketches of different k")
+        while len(self.compactors) < len(other.compactors):
+            self.grow()
+        for compactor, other_compactor in zip(
+            self.compactors, other.compactors
+        ):
+            compactor.extend(other_compactor)
+        self.n += other.n
+        self.size = sum(map(len, self.compactors))
+        while self.size >= self.max_size:
+            self.compress()
+
+    def quantile(self, q: float):
+        """Return the value at rank ``q * (n - 1)`` (0 <= q <= 1).
+
+        Values between adjacent ranks are linearly interpolated, so until
+        anything is compacted, results match the exact
+        ``c.ReduceFuncs.Percentile``.
+        """
+        cache = self.cache
+        if cache is None or cache[0] != self.n:
+            weighted = sorted(
+                (value, 1 << level)
+                for level, compactor in enumerate(self.compactors)
+                for value in compactor
+            )
+            values = [value for value, _ in weighted]
+            # cumulative[i] is the last rank covered by values[i]
+            cumulative = [
+                rank - 1
+                for rank in accumulate(weight for _, weight in weighted)
+            ]
+            cache = self.cache = (self.n, values, cumulative)
+        _, values, cumulative = cache
+
+        rank = cumulative[-1] * q
+        left_rank = int(rank)
+        index = bisect_left(cumulative, left_rank)
+        left_value = values[index]
+        if left_rank == rank:
+            return left_value
+        if cumulative[index] > left_rank:
+            # both ranks are covered by the same value
+            return left_value
+        return left_value + (values[index + 1] - left_value) * (
+            rank - left_rank
+        )
+
+
+class FrequentItems:
+    """Track the most frequent values keeping ``O(capacity)`` counters.
+
+    A Misra-Gries sketch: values are counted in a dict; once it exceeds
+    ``capacity`` counters, the median count is subtracted from all of them
+    and non-positive ones are dropped (amortized O(1) per value). Counts are
+    underestimated by at most ``offset``, which is the sum of subtracted
+    medians and doesn't exceed ``2 * n / capacity``, so any value more
+    frequent than that is retained.
+    """
+
+    __slots__ = ("capacity", "counts", "offset")
+
+    def __init__(self, capacity: int):
+        if not isinstance(capacity, int) or capacity < 1:
+            raise ValueError("capacity must be a positive int")
+        self.capacity = capacity
+        self.counts = {}
+        self.offset = 0
+
+    def add(self, value):
+        counts = self.counts
+        if value in counts:
+            counts[value] += 1
+        else:
+            counts[value] = 1
+            if len(counts) > self.capacity:
+                self.purge()
+
+    def purge(self):
+        counts = self.counts
+        median = sorted(counts.values())[len(counts) // 2]
+        self.offset += median
+        self.counts = {
+            value: count - median
+            for value, count in counts.items()
+            if count > median
+        }
+
+    def merge(self, other: "FrequentItems"):
+        counts = self.counts
+        for value, count in other.counts.items():
+            if value in counts:
+                counts[value] += count
+            else:
+                counts[value] = count
+        self.offset += other.offset
+        while len(self.counts) > self.capacity:
+            self.purge()
+
+    def top(self, k: int):
+        """Return up to ``k`` most frequent values, most frequent first."""
+        counts = self.counts
+        return [
+            value
+            for _, _, value in nlargest(
+                k, zip(counts.values(), count(0, -1), counts)
+            )
+        ]
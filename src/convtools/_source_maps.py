@@ -0,0 +1,214 @@
+"""Source maps from generated code back to conversions."""
+
+import json
+import os
+import re
+import sys
+import threading
+from bisect import bisect_right
+from collections import OrderedDict, namedtuple
+from typing import Any, Dict, List, Optional
+from weakref import ref
+
+
+_convtools_dir = os.path.dirname(os.path.abspath(__file__))
+_pattern_definition = re.compile(r"^\s*(?:def|class) (\w+)", re.MULTILINE)
+
+
+SourceMapEntry = namedtuple(
+    "SourceMapEntry",
+    [
+        "filename",
+        "first_line",
+        "last_line",
+        "name",
+        "description",
+        "call_site",
+        "conversion_ref",
+    ],
+)
+
+
+def find_call_site(depth=2) -> "Optional[str]":
+    """Return "filename:lineno" of the closest frame outside of convtools."""
+    try:
+        frame = sys._getframe(depth)  # pylint: disable=protected-access
+    except ValueError:  # pragma: no cover
+        return None
+    while frame is not None:
+        filename = frame.f_code.co_filename
+        if not filename.startswith(_convtools_dir):
+            return f"{filename}:{frame.f_lineno}"
+        frame = frame.f_back
+    return None  # pragma: no cover
+
+
+def describe_conversion(conversion) -> str:
+    call_site = getattr(conversion, "_call_site", None)
+    description = type(conversion).__name__
+    if call_site:
+        return f"{description} @ {call_site}"
+    return description
+
+
+class SourceMaps:
+    """Registry, which maps lines of generated code to conversions.
+
+    Disabled by default. Once enabled, conversions record call sites where
+    they are created and each compiled function is registered with the
+    conversion, which compiled it (e.g. the one ``gen_converter`` is called
+    on, ``group_by``, ``join``). Mapping is per function: all lines of a
+    function map to it, conversions inlined into the function are not
+    mapped separately. Only conversions created and compiled while enabled
+    get mapped.
+
+    Generated code may outlive conversions, so entries are kept until the
+    number of them exceeds ``max_entries``, then entries of files registered
+    first are evicted.
+    """
+
+    def __init__(self, max_entries=100000):
+        self.enabled = False
+        self.max_entries = max_entries
+        self._lock = threading.Lock()
+        self._filename_to_entries: "OrderedDict[str, List[SourceMapEntry]]" = (
+            OrderedDict()
+        )
+        # first lines of entries, parallel to them, to bisect on lookups
+        self._filename_to_first_lines: "Dict[str, List[int]]" = {}
+        self._entries_count = 0
+
+    def enable(self):
+        self.enabled = True
+
+    def disable(self):
+        self.enabled = False
+
+    def clear(self):
+        with self._lock:
+            self._filename_to_entries.clear()
+            self._filename_to_first_lines.clear()
+            self._entries_count = 0
+
+    def register(self, filename, code_str, conversion, line_offset=0):
+        """Register definitions of a compiled code piece."""
+        description = describe_conversion(conversion)
+        call_site = getattr(conversion, "_call_site", None)
+        try:
+            conversion_ref = ref(conversion)
+        except TypeError:  # pragma: no cover
+            conversion_ref = None
+
+        lines_before = code_str[: len(code_str) - len(code_str.lstrip())]
+        first_line = line_offset + lines_before.count("\n") + 1
+        last_line = line_offset + code_str.rstrip().count("\n") + 1
+        match = _pattern_definition.search(code_str)
+        entry = SourceMapEntry(
+            filename,
+            first_line,
+            last_line,
+            match.group(1) if match else "",
+            description,
+            call_site,
+            conversion_ref,
+        )
+        with self._lock:
+            entries = self._filename_to_entries.setdefault(filename, [])
+            self._filename_to_entries.move_to_end(filename)
+            first_lines = self._filename_to_first_lines.setdefault(
+                filename, []
+            )
+            index = bisect_right(first_lines, first_line)
+            first_lines.insert(index, first_line)
+            entries.insert(index, entry)
+
+            self._entries_count += 1
+            while (
+                self._entries_count > self.max_entries
+                and len(self._filename_to_entries) > 1
+            ):
+                evicted_filename, evicted_entries = (
+                    self._filename_to_entries.popitem(last=False)
+                )
+                del self._filename_to_first_lines[evicted_filename]
+                self._entries_count -= len(evicted_entries)
+
+    def lookup(self, filename, lineno) -> "Optional[SourceMapEntry]":
+        """Return the entry of a generated code line if any."""
+        with self._lock:
+            first_lines = self._filename_to_first_lines.get(filename)
+            if not first_lines:
+                return None
+            index = bisect_right(first_lines, lineno) - 1
+            if index < 0:
+                return None
+            entry = self._filename_to_entries[filename][index]
+        return entry if lineno <= entry.last_line else None
+
+    def get_conversion(self, filename, lineno) -> "Any":
+        """Return the conversion, which generated the line if still alive."""
+        entry = self.lookup(filename, lineno)
+        if entry is None or entry.conversion_ref is None:
+            return None
+        return entry.conversion_ref()
+
+    def to_dict(self) -> "Dict[str, List[Dict[str, Any]]]":
+        return {
+            filename: [
+                {
+                    "first_line": entry.first_line,
+                    "last_line": entry.last_line,
+                    "name": entry.name,
+                    "description": entry.description,
+                    "call_site": entry.call_site,
+                }
+                for entry in entries
+            ]
+            for filename, entries in self._filename_to_entries.items()
+        }
+
+    def dump(self, path):
+        """Write source maps as JSON, e.g. next to dumped sources."""
+        with open(path, "w", encoding="utf-8") as f:
+            json.dump(self.to_dict(), f, indent=2)
+
+    def annotate_stats(self, stats):
+        """Append conversion descriptions to function names in pstats.Stats.
+
+        Call before ``sort_stats`` / ``print_stats``, e.g.:
+
+        >>> stats = pstats.Stats(profile)
+        >>> c.source_maps.annotate_stats(stats).sort_stats("tottime")
+        """
+        key_to_new_key = {}
+
+        def annotate(key):
+            if key in key_to_new_key:
+                return key_to_new_key[key]
+            filename, lineno, name = key
+            entry = self.lookup(filename, lineno)
+            new_key = key_to_new_key[key] = (
+                key
+                if entry is None
+                else (filename, lineno, f"{name} [{entry.description}]")
+            )
+            return new_key
+
+        stats.stats = {
+            annotate(key): (
+                cc,
+                nc,
+                tt,
+                ct,
+                {
+                    annotate(caller): value
+                    for caller, value in callers.items()
+                },
+            )
+            for key, (cc, nc, tt, ct, callers) in stats.stats.items()
+        }
+        stats.fcn_list = None
+        return stats
+
+
+source_maps = SourceMaps()
@@ -5,12 +5,18 @@ e.g.
  - options ctx manager
 """
 
+import hashlib
+import marshal
 import os
 import sys
 import tempfile
 import threading
-from collections import defaultdict, deque
+from collections import OrderedDict, defaultdict, deque, namedtuple
 from importlib import import_module
+from importlib.util import MAGIC_NUMBER
+from itertools import chain, count
+from operator import itemgetter
+from time import perf_counter
 from weakref import finalize
 
 
@@ -18,11 +24,14 @@ PY_VERSION = sys.version_info[:2]
 if PY_VERSION == (3, 6):
 
     from typing import (  # type: ignore
+        Any,
         Dict,
         Generator,
         Generic,
         GenericMeta,
         Iterator,
+        List,
+        Optional,
         Tuple,
         Type,
         TypeVar,
@@ -36,7 +45,18 @@ if PY_VERSION == (3, 6):
             cls._ctx = threading.local()
 
 else:
-    from typing import Dict, Generator, Generic, Iterator, Tuple, Type, TypeVar
+    from typing import (
+        Any,
+        Dict,
+        Generator,
+        Generic,
+        Iterator,
+        List,
+        Optional,
+        Tuple,
+        Type,
+        TypeVar,
+    )
 
     class BaseCtxMeta(type):  # type: ignore
         def __init__(cls, name, bases, kwargs):
@@ -220,16 +240,63 @@ class CodePiece:
 
     __slots__ = (
         "converter_name",
-        "code_parts",
+        "_code_parts",
         "abs_path",
         "is_dumped",
+        "batch_piece",
+        "start",
+        "end",
     )
 
     def __init__(self, converter_name, code_parts, abs_path, is_dumped):
         self.converter_name = converter_name
-        self.code_parts = code_parts
+        self._code_parts = code_parts
         self.abs_path = abs_path
         self.is_dumped = is_dumped
+        # pieces compiled in a batch reference its source by offsets
+        self.batch_piece: "Optional[CodePiece]" = None
+        self.start = 0
+        self.end = 0
+
+    @property
+    def code_parts(self):
+        if self.batch_piece is None:
+            return self._code_parts
+        # sliced on access, so batched sources are kept once
+        return (self.batch_piece.code_parts[0][self.start : self.end],)
+
+    def move_to_batch(self, batch_piece, start, end):
+        self.batch_piece = batch_piece
+        self.start = start
+        self.end = end
+        self._code_parts = None
+
+
+class BatchedCodeKey:
+    """Key of a batched code piece, equal to the key of its source parts.
+
+    Replaces the key tuple, which references a copy of the source.
+    """
+
+    __slots__ = ("code_piece", "hash_")
+
+    def __init__(self, code_piece, hash_):
+        self.code_piece = code_piece
+        self.hash_ = hash_
+
+    def __hash__(self):
+        return self.hash_
+
+    def __eq__(self, other):
+        if isinstance(other, BatchedCodeKey):
+            other = other.get_key()
+        return self.get_key() == other
+
+    def get_key(self):
+        code_parts = "".join(self.code_piece.code_parts).partition(
+            f"def {self.code_piece.converter_name}("
+        )
+        return (code_parts[0], code_parts[2])
 
 
 class CodeStorage:
@@ -239,15 +306,23 @@ class CodeStorage:
     """
 
     def __init__(self):
-        self.key_to_code_piece: "Dict[str, CodePiece]" = {}
+        self.key_to_code_piece: "Dict[Any, CodePiece]" = {}
+        self.batch_code_pieces: "List[CodePiece]" = []
         self.converter_names = set()
-        finalize(self, drop_dumped_code, self.key_to_code_piece)
+        finalize(
+            self,
+            drop_dumped_code,
+            self.key_to_code_piece,
+            self.batch_code_pieces,
+        )
 
     def add_sources(self, converter_name, code_str):
-        def_name = f"def {converter_name}("
-        code_parts = (def_name, code_str.replace(def_name, ""))
+        # the key omits the name, so equal code pieces are deduplicated;
+        # it references the same strings as code_parts to avoid copies
+        code_parts = code_str.partition(f"def {converter_name}(")
+        key = (code_parts[0], code_parts[2])
 
-        code_piece = self.key_to_code_piece.get(code_parts[1])
+        code_piece = self.key_to_code_piece.get(key)
         if code_piece is not None:
             return code_piece, False
 
@@ -261,22 +336,63 @@ class CodeStorage:
         abs_path = os.path.join(
             debug_dir.get(), f"_{id(self)}_{converter_name}.py"
         )
-        code_piece = self.key_to_code_piece[code_parts[1]] = CodePiece(
+        code_piece = self.key_to_code_piece[key] = CodePiece(
             converter_name, code_parts, abs_path, False
         )
         return code_piece, True
 
+    def add_batch(self, code_pieces):
+        """Store sources of code pieces, which are compiled at once.
+
+        The joined source is kept once: code pieces and their keys
+        reference it instead of own copies.
+        """
+        batch_name = f"batch{len(self.batch_code_pieces)}"
+        abs_path = os.path.join(
+            debug_dir.get(), f"_{id(self)}_{batch_name}.py"
+        )
+        code_strs = ["".join(piece.code_parts) for piece in code_pieces]
+        batch_piece = CodePiece(
+            batch_name, ("\n".join(code_strs),), abs_path, False
+        )
+        self.batch_code_pieces.append(batch_piece)
+
+        start = 0
+        for code_piece, code_str in zip(code_pieces, code_strs):
+            end = start + len(code_str)
+            code_piece.move_to_batch(batch_piece, start, end)
+            start = end + 1
+
+        # rebuilt in place: finalize references the dict; keeps the order
+        batched_ids = set(map(id, code_pieces))
+        items = [
+            (
+                (
+                    BatchedCodeKey(code_piece, hash(key))
+                    if id(code_piece) in batched_ids
+                    else key
+                ),
+                code_piece,
+            )
+            for key, code_piece in self.key_to_code_piece.items()
+        ]
+        self.key_to_code_piece.clear()
+        self.key_to_code_piece.update(items)
+        return batch_piece
+
     def dump_sources(self):
         debug_dir.ensure_initialized()
-        for code_piece in self.key_to_code_piece.values():
+        for code_piece in chain(
+            self.key_to_code_piece.values(), self.batch_code_pieces
+        ):
             if not code_piece.is_dumped:
                 with open(code_piece.abs_path, "w", encoding="utf-8") as f:
                     f.write("".join(code_piece.code_parts))
                 code_piece.is_dumped = True
 
 
-def drop_dumped_code(key_to_code_piece):
-    for code_piece in key_to_code_piece.values():
+def drop_dumped_code(key_to_code_piece, batch_code_pieces):
+    for code_piece in chain(key_to_code_piece.values(), batch_code_pieces):
         if code_piece.is_dumped:
             try:
                 os.remove(code_piece.abs_path)
@@ -284,6 +400,423 @@ def drop_dumped_code(key_to_code_piece):
                 pass
 
 
+CacheInfo = namedtuple("CacheInfo", ["hits", "misses", "maxsize", "currsize"])
+
+
+class LRUCache:
+    """Thread-safe bounded mapping, which evicts least recently used items.
+
+    Mirrors ``functools.lru_cache`` API for stats: ``cache_info`` and
+    ``cache_clear``.
+    """
+
+    def __init__(self, maxsize=256):
+        self.maxsize = maxsize
+        self.hits = 0
+        self.misses = 0
+        self._data: "OrderedDict" = OrderedDict()
+        self._lock = threading.Lock()
+
+    def get(self, key, default=None):
+        with self._lock:
+            try:
+                value = self._data[key]
+            except KeyError:
+                self.misses += 1
+                return default
+            self._data.move_to_end(key)
+            self.hits += 1
+            return value
+
+    def set(self, key, value):
+        with self._lock:
+            if self.maxsize <= 0:
+                return
+            self._data[key] = value
+            self._data.move_to_end(key)
+            while len(self._data) > self.maxsize:
+                self._data.popitem(last=False)
+
+    def resize(self, maxsize):
+        with self._lock:
+            self.maxsize = maxsize
+            while len(self._data) > max(maxsize, 0):
+                self._data.popitem(last=False)
+
+    def cache_info(self) -> CacheInfo:
+        with self._lock:
+            return CacheInfo(
+                self.hits, self.misses, self.maxsize, len(self._data)
+            )
+
+    def cache_clear(self):
+        with self._lock:
+            self._data.clear()
+            self.hits = self.misses = 0
+
+    def __len__(self):
+        return len(self._data)
+
+
+def replace_code_filename(code_obj, filename):
+    return code_obj.replace(
+        co_filename=filename,
+        co_consts=tuple(
+            (
+                replace_code_filename(const, filename)
+                if isinstance(const, type(code_obj))
+                else const
+            )
+            for const in code_obj.co_consts
+        ),
+    )
+
+
+class BytecodeCache:
+    """Opt-in on-disk cache of code objects of generated converters.
+
+    Entries are keyed by the generated source, convtools version and
+    interpreter version, so later processes skip ``compile`` calls. Only
+    marshalled code objects are stored: naive values are not serialized, they
+    are still put into globals of generated code during code generation.
+
+    It is enabled by either ``PY_CONVTOOLS_BYTECODE_CACHE_DIR`` environment
+    variable or ``enable`` method.
+    """
+
+    # code.replace is available since 3.8
+    is_supported = hasattr(compile("", "", "exec"), "replace")
+
+    def __init__(self):
+        self.cache_dir = None
+        self.dir_initialized = False
+        self.env_checked = False
+        self.hits = 0
+        self.misses = 0
+        self._version_salt = None
+
+    def enable(self, cache_dir):
+        self.cache_dir = cache_dir
+        self.dir_initialized = False
+        self.env_checked = True
+
+    def disable(self):
+        self.cache_dir = None
+        self.env_checked = True
+
+    def get_dir(self):
+        if not self.env_checked:
+            self.cache_dir = os.environ.get(
+                "PY_CONVTOOLS_BYTECODE_CACHE_DIR", None
+            )
+            self.env_checked = True
+        return self.cache_dir if self.is_supported else None
+
+    def gen_key(self, code_str, optimize):
+        if self._version_salt is None:
+            self._version_salt = "|".join(
+                (
+                    import_module("convtools").__version__,
+                    sys.version,
+                    MAGIC_NUMBER.hex(),
+                )
+            )
+        return hashlib.sha256(
+            f"{self._version_salt}|{optimize}|{code_str}".encode("utf-8")
+        ).hexdigest()
+
+    def compile(self, code_str, filename, optimize):
+        cache_dir = self.get_dir()
+        if cache_dir is None:
+            return compile(code_str, filename, "exec", optimize=optimize)
+
+        path = os.path.join(
+            cache_dir, f"{self.gen_key(code_str, optimize)}.marshal"
+        )
+        try:
+            with open(path, "rb") as f:
+                code_obj = marshal.loads(f.read())
+        except (OSError, EOFError, ValueError, TypeError):
+            pass
+        else:
+            self.hits += 1
+            return replace_code_filename(code_obj, filename)
+
+        self.misses += 1
+        code_obj = compile(code_str, filename, "exec", optimize=optimize)
+        try:
+            if not self.dir_initialized:
+                os.makedirs(cache_dir, exist_ok=True)
+                self.dir_initialized = True
+            tmp_path = f"{path}.{os.getpid()}.{threading.get_ident()}.tmp"
+            with open(tmp_path, "wb") as f:
+                f.write(marshal.dumps(code_obj))
+            os.replace(tmp_path, path)
+        except OSError:  # pragma: no cover
+            pass
+        return code_obj
+
+    def clear(self):
+        cache_dir = self.get_dir()
+        if cache_dir and os.path.isdir(cache_dir):
+            for name in os.listdir(cache_dir):
+                if name.endswith(".marshal"):
+                    os.remove(os.path.join(cache_dir, name))
+        self.hits = self.misses = 0
+
+
+bytecode_cache = BytecodeCache()
+
+
+_first_item = itemgetter(0)
+
+
+class RowsCounter:
+    """Counter of rows, which is advanced by generated code at C speed.
+
+    Iterables are counted by zipping them with ``itertools.count``, single
+    rows (e.g. passing a filter) by calling ``next`` on ``self.counter``.
+    """
+
+    __slots__ = ("counter", "offset", "reads")
+
+    def __init__(self):
+        self.counter = count()
+        self.offset = 0
+        # number of times the counter was advanced to be read
+        self.reads = 0
+
+    def count_iter(self, iterable):
+        # zip stops before advancing the counter, once iterable is exhausted
+        return map(_first_item, zip(iterable, self.counter))
+
+    def add(self, number):
+        self.offset += number
+
+    def get_raw_value(self) -> int:
+        # count has no public getter of its state, so it is read by
+        # advancing it, which is accounted for by reads
+        value = next(self.counter) - self.reads
+        self.reads += 1
+        return value
+
+    @property
+    def value(self) -> int:
+        return self.get_raw_value() + self.offset
+
+    def reset(self):
+        # generated code references the counter, so it cannot be replaced
+        self.offset = -self.get_raw_value()
+
+
+class RuntimeCounters:
+    """Counters of rows passing through stages of an instrumented converter.
+
+    Stages are comprehensions (``iter``/``filter``), ``group_by``/
+    ``aggregate`` and ``join`` conversions, named by kind and index in order
+    of code generation, e.g. ``filter_0``.
+    """
+
+    def __init__(self):
+        self.stages: "Dict[str, Dict[str, RowsCounter]]" = {}
+
+    def add_stage(self, kind: str, *counter_names: str):
+        name = f"{kind}_{len(self.stages)}"
+        counters = self.stages[name] = {
+            counter_name: RowsCounter() for counter_name in counter_names
+        }
+        return counters
+
+    def snapshot(self) -> "Dict[str, Dict[str, Any]]":
+        """Return counter values per stage and selectivity where possible."""
+        result = {}
+        for name, counters in self.stages.items():
+            values = result[name] = {
+                counter_name: counter.value
+                for counter_name, counter in counters.items()
+            }
+            rows_in = values.get("rows_in", values.get("left_rows"))
+            rows_out = values.get("rows_out", values.get("groups"))
+            if rows_in is not None and rows_out is not None:
+                values["selectivity"] = (
+                    rows_out / rows_in if rows_in else None
+                )
+        return result
+
+    def reset(self):
+        for counters in self.stages.values():
+            for counter in counters.values():
+                counter.reset()
+
+
+class ProfilerPhase:
+    """Context manager, which times a single call of a codegen phase."""
+
+    __slots__ = ("profiler", "key", "started", "children_time")
+
+    def __init__(self, profiler, key):
+        self.profiler = profiler
+        self.key = key
+        self.started = 0.0
+        self.children_time = 0.0
+
+    def __enter__(self):
+        self.profiler.stack.append(self)
+        depth = self.profiler.key_to_depth
+        depth[self.key] = depth.get(self.key, 0) + 1
+        phase = self.key[0]
+        depth[phase] = depth.get(phase, 0) + 1
+        self.started = perf_counter()
+
+    def __exit__(self, exc_type, exc_value, tb):
+        elapsed = perf_counter() - self.started
+        profiler = self.profiler
+        profiler.stack.pop()
+        if profiler.stack:
+            profiler.stack[-1].children_time += elapsed
+
+        record = profiler.records.get(self.key)
+        if record is None:
+            record = profiler.records[self.key] = [0, 0.0, 0.0]
+        record[0] += 1
+        record[2] += elapsed - self.children_time
+        # recursive calls are counted once in inclusive time
+        depth = profiler.key_to_depth
+        depth[self.key] -= 1
+        if not depth[self.key]:
+            record[1] += elapsed
+        phase = self.key[0]
+        depth[phase] -= 1
+        if not depth[phase]:
+            profiler.phase_to_time[phase] = (
+                profiler.phase_to_time.get(phase, 0.0) + elapsed
+            )
+
+
+class NullPhase:
+    """No-op replacement of ProfilerPhase, when profiling is off."""
+
+    __slots__ = ()
+
+    def __enter__(self):
+        pass
+
+    def __exit__(self, exc_type, exc_value, tb):
+        pass
+
+
+null_phase = NullPhase()
+
+
+def profile_phase(phase: str, name: str = ""):
+    """Time a codegen phase, if a CodegenProfiler is active."""
+    if CodegenProfiler.active_count:
+        profiler = CodegenProfiler.get_active()
+        if profiler is not None:
+            return profiler.phase(phase, name)
+    return null_phase
+
+
+class CodegenProfiler:
+    """Opt-in profiler of code generation phases.
+
+    Records calls, inclusive and self wall time per phase (``gen_code``,
+    ``gen_name``, ``replace_word``, ``black``, ``compile``, ``exec``, etc.)
+    and per conversion class for converters generated within the context in
+    the current thread.
+
+    >>> with c.CodegenProfiler() as profiler:
+    ...     converter = conversion.gen_converter()
+    >>> profiler.report()
+    """
+
+    # number of active profilers in all threads to skip thread-local
+    # lookups when none is active
+    active_count = 0
+    _lock = threading.Lock()
+    _local = threading.local()
+
+    def __init__(self):
+        self.records: "Dict[Tuple[str, str], List]" = {}
+        self.stack: "List[ProfilerPhase]" = []
+        self.key_to_depth: "Dict[Any, int]" = {}
+        self.phase_to_time: "Dict[str, float]" = {}
+        self.prev_profiler = None
+
+    @classmethod
+    def get_active(cls) -> "Optional[CodegenProfiler]":
+        return getattr(cls._local, "profiler", None)
+
+    def __enter__(self):
+        self.prev_profiler = self.get_active()
+        self._local.profiler = self
+        with self._lock:
+            CodegenProfiler.active_count += 1
+        return self
+
+    def __exit__(self, exc_type, exc_value, tb):
+        self._local.profiler = self.prev_profiler
+        self.prev_profiler = None
+        with self._lock:
+            CodegenProfiler.active_count -= 1
+
+    def phase(self, phase: str, name: str = "") -> ProfilerPhase:
+        return ProfilerPhase(self, (phase, name))
+
+    def report(self) -> "Dict[str, Any]":
+        """Return JSON-serializable report.
+
+        ``total_time`` is wall time spent in profiled phases; ``time`` is
+        inclusive of nested phases, while ``self_time`` is not, so self times
+        sum up to the total.
+        """
+        phases: "Dict[str, Dict[str, Any]]" = {}
+        conversions: "Dict[str, Dict[str, Any]]" = {}
+        for (phase, name), (calls, time, self_time) in self.records.items():
+            phase_stats = phases.setdefault(
+                phase,
+                {
+                    "calls": 0,
+                    "time": self.phase_to_time.get(phase, 0.0),
+                    "self_time": 0.0,
+                },
+            )
+            phase_stats["calls"] += calls
+            phase_stats["self_time"] += self_time
+            if phase == "gen_code":
+                conversions[name] = {
+                    "calls": calls,
+                    "time": time,
+                    "self_time": self_time,
+                }
+
+        def by_self_time(item):
+            return -item[1]["self_time"]
+
+        return {
+            "total_time": sum(
+                stats["self_time"] for stats in phases.values()
+            ),
+            "phases": dict(sorted(phases.items(), key=by_self_time)),
+            "conversions": dict(sorted(conversions.items(), key=by_self_time)),
+        }
+
+    def format_report(self, limit=20) -> str:
+        """Format the report as a text table."""
+        report = self.report()
+        lines = [f"total: {report['total_time']:.6f}s"]
+        for title in ("phases", "conversions"):
+            lines.append(
+                f"{title:<32} {'calls':>8} {'time, s':>10} {'self, s':>10}"
+            )
+            for name, stats in list(report[title].items())[:limit]:
+                lines.append(
+                    f"{name:<32} {stats['calls']:>8} "
+                    f"{stats['time']:>10.6f} {stats['self_time']:>10.6f}"
+                )
+        return "\n".join(lines)
+
+
 T = TypeVar("T")
 
 
@@ -340,6 +873,10 @@ class _None:
     parameters.
     """
 
+    def __reduce__(self):
+        # unpickled as the very same instance, e.g. in partial states
+        return "_none"
+
 
 _none = _None()
 
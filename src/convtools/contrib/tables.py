@@ -42,7 +42,12 @@ from .._base import (
     ensure_conversion,
 )
 from .._columns import ColumnChanges, ColumnRef, MetaColumns
-from .._joins import JoinConversion, LeftJoinCondition, RightJoinCondition
+from .._joins import (
+    AsofJoinConversion,
+    JoinConversion,
+    LeftJoinCondition,
+    RightJoinCondition,
+)
 
 
 _none = BaseConversion._none
@@ -688,6 +693,10 @@ class Table:
         on: "Union[BaseConversion, str, Iterable[str]]",
         how: str,
         suffixes=("_LEFT", "_RIGHT"),
+        presorted=False,
+        by: "Union[str, Iterable[str], None]" = None,
+        direction=None,
+        tolerance=None,
     ) -> "Table":
         """Classic table join.
 
@@ -699,12 +708,39 @@ class Table:
             * or iterable of column names to join on
 
           how: either of these: "inner", "left", "right", "outer" (same as
-            "full")
+            "full"), "asof": ``on`` is a name of a column, both tables are
+            sorted by, each left row is joined to the nearest right one
+            (see ``c.asof_join``)
           suffixes: tuple of two strings: the first one is the suffix to be
             added to left columns, having conflicting names with right columns;
             the second one is added to conflicting right ones. When ``on`` is
             an iterable of strings, these columns are excluded from suffixing.
+          presorted: both tables are sorted by columns of equality
+            conditions, so rows are merged as they are read, without loading
+            the right table into memory (sort-merge join)
+          by: (asof only) column name(s) to partition rows by, only rows of
+            equal values are joined
+          direction: (asof only) "backward" (default), "forward" or
+            "nearest"
+          tolerance: (asof only) max distance between ``on`` values
         """
+        is_asof = how == "asof"
+        if not is_asof and (
+            by is not None or direction is not None or tolerance is not None
+        ):
+            raise ValueError(
+                "by, direction and tolerance are supported by asof joins only"
+            )
+        if is_asof:
+            if not isinstance(on, str):
+                raise ValueError("asof join expects on to be a column name")
+            if by is None:
+                by = []
+            elif isinstance(by, str):
+                by = [by]
+            else:
+                by = list(by)
+            how = "left"
         how = JoinConversion.validate_how(how)
         left = self.embed_conversions()
         right = table.embed_conversions()
@@ -725,7 +761,39 @@ class Table:
         after_join_conversions: "List[BaseConversion]" = []
         after_join_column_names: "List[str]" = []
 
-        if isinstance(on, BaseConversion):
+        if is_asof:
+            join_columns = {on, *by}
+            join_conversion = AsofJoinConversion(
+                This(),
+                InputArg("right"),
+                on=(
+                    GetItem(left_column_name_to_column[on].index),
+                    GetItem(right_column_name_to_column[on].index),
+                ),
+                by=(
+                    (
+                        Tuple_(
+                            *(
+                                GetItem(left_column_name_to_column[name].index)
+                                for name in by
+                            )
+                        ),
+                        Tuple_(
+                            *(
+                                GetItem(
+                                    right_column_name_to_column[name].index
+                                )
+                                for name in by
+                            )
+                        ),
+                    )
+                    if by
+                    else None
+                ),
+                direction=direction or "backward",
+                tolerance=tolerance,
+            )
+        elif isinstance(on, BaseConversion):
             # intentionally left blank to force suffixing
             join_columns = set()
             join_condition = on
@@ -815,12 +883,15 @@ class Table:
                     else GetItem(1, index)
                 )
 
-        new_rows = JoinConversion(
-            This(),
-            InputArg("right"),
-            join_condition,
-            how,
-        ).execute(
+        if not is_asof:
+            join_conversion = JoinConversion(
+                This(),
+                InputArg("right"),
+                join_condition,
+                how,
+                sorted=presorted,
+            )
+        new_rows = join_conversion.execute(
             left.into_iter_rows(left.row_type),
             right=right.into_iter_rows(right.row_type),
             debug=ConverterOptionsCtx.get_option_value("debug"),
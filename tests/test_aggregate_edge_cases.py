@@ -183,6 +183,13 @@ def test_mode(series):
     )
 
 
+def test_mode_ties():
+    # the last of the most common values
+    assert c.aggregate(c.ReduceFuncs.Mode(c.this)).execute([1, 2, 2, 1]) == 2
+    assert c.aggregate(c.ReduceFuncs.Mode(c.this)).execute([2, 1, 1, 2]) == 1
+    assert c.aggregate(c.ReduceFuncs.Mode(c.this)).execute([None, 1]) == 1
+
+
 def test_mode_with_groupby():
     series = [(0, 1), (0, 1), (0, 2), (1, 1), (1, 2), (1, 2)]
 
@@ -0,0 +1,281 @@
+import pickle
+from bisect import bisect_left
+from collections import Counter
+from random import Random
+
+import pytest
+
+from convtools import conversion as c
+from convtools._sketches import KLL, FrequentItems, HyperLogLog
+from tests.utils import get_code_str
+
+
+R = c.ReduceFuncs
+
+
+@pytest.mark.parametrize("precision", [4, 12, 16])
+@pytest.mark.parametrize("n", [1, 10, 1000, 100000])
+def test_approx_count_distinct(precision, n):
+    # hashes of ints don't depend on PYTHONHASHSEED, so are reproducible
+    data = list(range(n)) * 2
+    result = c.aggregate(
+        R.ApproxCountDistinct(c.this, precision=precision)
+    ).execute(data)
+    # 4 standard errors
+    assert abs(result - n) <= 4 * HyperLogLog.error_bound(precision) * n
+
+
+@pytest.mark.parametrize("factor", [1, 2.5, 4])
+def test_approx_count_distinct_bias(factor):
+    # raw estimates are biased around 2.5 * m, where linear counting stops
+    precision = 10
+    n = int(factor * (1 << precision))
+    errors = []
+    for run in range(40):
+        sketch = HyperLogLog(precision)
+        for i in range(n):
+            sketch.add((run, i))
+        errors.append(sketch.count() / n - 1)
+    assert abs(sum(errors) / len(errors)) < 0.01
+
+
+def test_approx_count_distinct_group_by():
+    rows = [{"a": i % 3, "b": i % 1000} for i in range(30000)]
+    reducer = {
+        "a": c.item("a"),
+        "count": R.ApproxCountDistinct(c.item("b"), where=c.item("b") < 500),
+    }
+    expected = (
+        c.group_by(c.item("a"))
+        .aggregate(
+            {
+                "a": c.item("a"),
+                "count": R.CountDistinct(
+                    c.item("b"), where=c.item("b") < 500
+                ),
+            }
+        )
+        .execute(rows)
+    )
+    result = c.group_by(c.item("a")).aggregate(reducer).execute(rows)
+    assert [row["a"] for row in result] == [0, 1, 2]
+    for row, expected_row in zip(result, expected):
+        assert abs(row["count"] - expected_row["count"]) <= 10
+
+    assert c.aggregate(R.ApproxCountDistinct(c.item("b"))).execute([]) == 0
+    assert (
+        c.aggregate(
+            R.ApproxCountDistinct(c.item("b"), where=c.item("b") < 0)
+        ).execute(rows)
+        == 0
+    )
+
+    # merging sketches is the same as building a sketch of the whole input
+    aggregation = c.group_by(c.item("a")).aggregate(reducer)
+    merged = aggregation.merge_partials().execute(
+        [
+            pickle.loads(pickle.dumps(aggregation.partial().execute(chunk)))
+            for chunk in (rows[:10000], rows[10000:12345], rows[12345:])
+        ]
+    )
+    assert merged == result
+    assert (
+        c.group_by(c.item("a"))
+        .aggregate(reducer, parallel=2, batch_size=5000)
+        .execute(rows)
+        == result
+    )
+
+    aggregator = aggregation.gen_aggregator()
+    aggregator.update(rows[:10000])
+    aggregator.update(rows[10000:])
+    assert aggregator.snapshot() == aggregator.snapshot() == result
+
+
+def test_approx_count_distinct_errors():
+    with pytest.raises(ValueError, match="precision"):
+        R.ApproxCountDistinct(c.this, precision=3)
+    with pytest.raises(ValueError, match="precision"):
+        R.ApproxCountDistinct(c.this, precision=17)
+    with pytest.raises(ValueError, match="precision"):
+        HyperLogLog(10).merge(HyperLogLog(11))
+
+
+def rank_error(sorted_values, value, q):
+    rank = bisect_left(sorted_values, value) / (len(sorted_values) - 1)
+    return abs(rank - q)
+
+
+@pytest.mark.parametrize("k", [8, 200])
+@pytest.mark.parametrize("n", [1, 2, 10, 1000, 100000])
+def test_approx_percentile(k, n):
+    random = Random(n)
+    data = [random.random() for _ in range(n)]
+    percentiles = [0, 1, 25, 50, 95, 100]
+    result = c.aggregate(
+        [R.ApproxPercentile(p, c.this, k=k) for p in percentiles]
+    ).execute(data)
+    if n < k:
+        assert result == c.aggregate(
+            [R.Percentile(p, c.this) for p in percentiles]
+        ).execute(data)
+    else:
+        sorted_data = sorted(data)
+        for p, value in zip(percentiles, result):
+            assert rank_error(sorted_data, value, p / 100) <= 4 / k
+
+
+def test_approx_percentile_group_by():
+    random = Random(1)
+    rows = [
+        {"a": i % 3, "b": random.random() if i % 5 else None}
+        for i in range(30000)
+    ]
+    reducer = {
+        "a": c.item("a"),
+        "median": R.ApproxMedian(c.item("b")),
+        "p95": R.ApproxPercentile(95, c.item("b")),
+        "filtered": R.ApproxMedian(c.item("b"), where=c.item("a") > 10),
+    }
+    aggregation = c.group_by(c.item("a")).aggregate(reducer)
+    converter = aggregation.gen_converter()
+    # percentiles of the same value share a single sketch
+    assert get_code_str(converter).count("KLL(200)") == 2
+
+    result = converter(rows)
+    exact = (
+        c.group_by(c.item("a"))
+        .aggregate(R.Array(c.item("b"), where=c.item("b")).pipe(sorted))
+        .execute(rows)
+    )
+    for row, sorted_values in zip(result, exact):
+        assert rank_error(sorted_values, row["median"], 0.5) <= 0.02
+        assert rank_error(sorted_values, row["p95"], 0.95) <= 0.02
+        assert row["filtered"] is None
+
+    merged = aggregation.merge_partials().execute(
+        [
+            pickle.loads(pickle.dumps(aggregation.partial().execute(chunk)))
+            for chunk in (rows[:10000], rows[10000:12345], rows[12345:])
+        ]
+    )
+    for row, sorted_values in zip(merged, exact):
+        assert rank_error(sorted_values, row["median"], 0.5) <= 0.02
+        assert rank_error(sorted_values, row["p95"], 0.95) <= 0.02
+
+    aggregator = aggregation.gen_aggregator()
+    aggregator.update(rows[:10000])
+    aggregator.update(rows[10000:])
+    assert aggregator.snapshot() == aggregator.snapshot() == result
+
+
+def test_approx_percentile_sketch_is_bounded():
+    sketch = KLL(100)
+    for i in range(100000):
+        sketch.add(i)
+    assert sum(map(len, sketch.compactors)) <= sketch.max_size <= 400
+    assert sketch.n == 100000
+
+    other = KLL(100)
+    for i in range(100000, 150000):
+        other.add(i)
+    sketch.merge(other)
+    assert sum(map(len, sketch.compactors)) < sketch.max_size
+    assert rank_error(range(150000), sketch.quantile(0.5), 0.5) <= 0.04
+
+
+def test_approx_percentile_errors():
+    with pytest.raises(ValueError, match="percentile"):
+        R.ApproxPercentile(101, c.this)
+    with pytest.raises(ValueError, match="k must"):
+        R.ApproxMedian(c.this, k=7)
+    with pytest.raises(ValueError, match="k"):
+        KLL(10).merge(KLL(11))
+
+
+def gen_heavy_hitters(n, seed):
+    random = Random(seed)
+    # 10 values make up 50% of the input, the rest is unique noise
+    return [
+        f"hot{i % 10}" if random.random() < 0.5 else f"noise{i}"
+        for i in range(n)
+    ]
+
+
+@pytest.mark.parametrize("capacity", [20, 1000])
+def test_approx_top(capacity):
+    data = gen_heavy_hitters(100000, capacity)
+    expected = [value for value, _ in Counter(data).most_common(3)]
+    result = c.aggregate(
+        R.ApproxTop(3, c.this, capacity=capacity)
+    ).execute(data)
+    assert set(result) <= {f"hot{i}" for i in range(10)}
+    assert len(result) == 3
+    if capacity == 1000:
+        assert result == expected
+
+    # exact until capacity is exceeded, ties are kept in order of appearance
+    assert c.aggregate(R.ApproxTop(2, c.this)).execute(
+        [1, 2, 3, 3, 2, None, None, None]
+    ) == [None, 2]
+    assert c.aggregate(R.ApproxTop(10, c.this)).execute([1, 2]) == [1, 2]
+    assert c.aggregate(R.ApproxTop(10, c.this)).execute([]) is None
+
+
+def test_approx_top_group_by():
+    data = gen_heavy_hitters(30000, 1)
+    rows = [{"a": i % 3, "b": value} for i, value in enumerate(data)]
+    aggregation = c.group_by(c.item("a")).aggregate(
+        {
+            "a": c.item("a"),
+            "top": R.ApproxTop(10, c.item("b"), capacity=100),
+        }
+    )
+    result = aggregation.execute(rows)
+    hot = {f"hot{i}" for i in range(10)}
+    assert [row["a"] for row in result] == [0, 1, 2]
+    assert all(set(row["top"]) == hot for row in result)
+
+    merged = aggregation.merge_partials().execute(
+        [
+            pickle.loads(pickle.dumps(aggregation.partial().execute(chunk)))
+            for chunk in (rows[:10000], rows[10000:12345], rows[12345:])
+        ]
+    )
+    assert all(set(row["top"]) == hot for row in merged)
+
+    aggregator = aggregation.gen_aggregator()
+    aggregator.update(rows[:10000])
+    aggregator.update(rows[10000:])
+    assert aggregator.snapshot() == aggregator.snapshot() == result
+
+
+def test_approx_top_sketch_is_bounded():
+    data = gen_heavy_hitters(100000, 2)
+    sketch = FrequentItems(50)
+    for value in data:
+        sketch.add(value)
+        assert len(sketch.counts) <= 50
+    assert sketch.offset <= 2 * len(data) / 50
+    exact = Counter(data)
+    for value, count in sketch.counts.items():
+        assert count <= exact[value] <= count + sketch.offset
+
+    other = FrequentItems(50)
+    for value in data:
+        other.add(value)
+    sketch.merge(other)
+    assert len(sketch.counts) <= 50
+    for value in (f"hot{i}" for i in range(10)):
+        assert sketch.counts[value] <= 2 * exact[value]
+
+
+def test_approx_top_errors():
+    with pytest.raises(TypeError):
+        R.ApproxTop("1", c.this)
+    with pytest.raises(ValueError):
+        R.ApproxTop(0, c.this)
+    with pytest.raises(ValueError, match="capacity"):
+        R.ApproxTop(10, c.this, capacity=0)
+    with pytest.raises(ValueError, match="capacity"):
+        R.ApproxTop(10, c.this, capacity=9)
@@ -0,0 +1,120 @@
+import linecache
+import traceback
+from unittest.mock import patch
+
+import pytest
+
+from convtools import conversion as c
+from convtools._utils import CodeStorage, bytecode_cache
+
+
+def build_conversions():
+    return {
+        "totals": c.group_by(c.item("a")).aggregate(
+            {
+                "a": c.item("a"),
+                "sum": c.ReduceFuncs.Sum(c.item("b")),
+                "array": c.ReduceFuncs.Array(
+                    c.item("b"), where=c.item("b") > 1
+                ),
+            }
+        ),
+        "total": c.aggregate(c.ReduceFuncs.Sum(c.item("b"))),
+        "rows": c.iter({"b": c.item("b"), "l": c.naive([1, 2])}).as_type(
+            list
+        ),
+        "names": c.iter(c.item("name", default=None)).as_type(list),
+        "same_names": c.iter(c.item("name", default=None)).as_type(list),
+        "dispatch": c.iter(
+            c.this.dispatch(
+                c.item("a"),
+                {1: c.item("b") + 1, 2: c.item("b") - 1},
+                default=c.item("b"),
+            )
+        ).as_type(list),
+    }
+
+
+DATA = [{"a": 1, "b": 1}, {"a": 1, "b": 2}, {"a": 3, "b": 3}]
+
+
+def test_gen_converters():
+    compile_ = bytecode_cache.compile
+    with patch.object(
+        bytecode_cache, "compile", side_effect=compile_
+    ) as mock:
+        converters = c.gen_converters(build_conversions())
+    # dispatch branches are used as values, so they are compiled
+    # separately; everything else at once
+    assert mock.call_count == 2
+
+    assert list(converters) == list(build_conversions())
+    for name, conversion in build_conversions().items():
+        assert converters[name](DATA) == conversion.execute(DATA)
+
+    # all converters share the same globals
+    assert len({id(f.__globals__) for f in converters.values()}) == 1
+
+    class A:
+        k = 2
+        locals().update(
+            c.gen_converters(
+                {
+                    "double": c.this * c.input_arg("cls").attr("k"),
+                    "triple": c.this * (c.input_arg("cls").attr("k") + 1),
+                },
+                class_method=True,
+            )
+        )
+
+    assert A.double(2) == 4 and A().triple(2) == 6
+
+
+def test_batch_sources_are_stored_once():
+    storage = CodeStorage()
+    code_f = "def f(x):\n    return x\n"
+    code_g = "def g(x):\n    return 1\n"
+    piece_f, _ = storage.add_sources("f", code_f)
+    piece_g, _ = storage.add_sources("g", code_g)
+    batch_piece = storage.add_batch([piece_f, piece_g])
+    assert batch_piece.code_parts == (f"{code_f}\n{code_g}",)
+    assert "".join(piece_f.code_parts) == code_f
+    assert "".join(piece_g.code_parts) == code_g
+    assert piece_f._code_parts is None
+
+    # batched pieces are still deduplicated
+    assert storage.add_sources("h", "def h(x):\n    return x\n") == (
+        piece_f,
+        False,
+    )
+    piece_h, added = storage.add_sources("h", "def h(x):\n    return 2\n")
+    assert added and piece_h not in (piece_f, piece_g)
+    assert list(storage.key_to_code_piece.values()) == [
+        piece_f,
+        piece_g,
+        piece_h,
+    ]
+
+
+def test_gen_converters_debug(capsys):
+    converters = c.gen_converters(
+        {"inc": c.this + 1, "dec": c.this - 1}, debug=True
+    )
+    assert converters["inc"](1) == 2 and converters["dec"](1) == 0
+    out = capsys.readouterr().out
+    assert "def _inc(" in out and "def _dec(" in out
+
+
+def test_gen_converters_tracebacks():
+    converters = c.gen_converters(
+        {"inc": c.item("a") + 1, "dec": c.item("a") - 1}
+    )
+    with pytest.raises(TypeError) as exc_info:
+        converters["dec"]({"a": None})
+
+    frame_summary = traceback.extract_tb(exc_info.tb)[-1]
+    assert "batch" in frame_summary.filename
+    assert frame_summary.line == linecache.getline(
+        frame_summary.filename, frame_summary.lineno
+    ).strip()
+    assert "- 1" in frame_summary.line
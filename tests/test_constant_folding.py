@@ -0,0 +1,136 @@
+import pytest
+
+from convtools import conversion as c
+from tests.utils import get_code_str
+
+
+def get_return_code(conversion):
+    code = get_code_str(conversion.gen_converter())
+    return code.split("return ", 1)[1].split("\n", 1)[0]
+
+
+def test_operators_are_folded():
+    assert get_return_code(c.naive(3600) * 24) == "86400"
+    assert get_return_code(c.this * (c.naive(3600) * 24)) == "(data_ * 86400)"
+    assert get_return_code(c.naive("a") + "b") == "'ab'"
+    assert get_return_code(c.not_(c.naive(0))) == "True"
+    assert get_return_code(c.naive(1) < 2) == "True"
+    assert get_return_code(-c.naive(2)) == "(-2)"
+    assert get_return_code(c.naive(0.5) * 4) == "2.0"
+    assert (c.naive(3600) * 24).execute(None) == 86400
+
+
+def test_folding_is_skipped():
+    # runtime errors are preserved
+    with pytest.raises(ZeroDivisionError):
+        (c.naive(1) / 0).execute(None)
+
+    # no huge literals
+    assert get_return_code(c.naive("ab") * 1000) == "('ab' * 1000)"
+    assert get_return_code(c.naive(2) ** 1000) == "(2 ** 1000)"
+    assert get_return_code((c.naive(2) ** 256) ** 256) == (
+        "(115792089237316195423570985008687907853269984665640564039457584007"
+        "913129639936 ** 256)"
+    )
+    assert ((c.naive(2) ** 256) ** 256).execute(None) == 2**65536
+
+    # results of unsupported types
+    assert get_return_code(c.naive(1.5) + c.naive(b"x")) == "(1.5 + b'x')"
+    assert c.inline_expr("{0} + 1").pass_args(1).execute(None) == 2
+    assert get_return_code(
+        c.inline_expr("{0} + 1").pass_args(c.this)
+    ) == "(data_ + 1)"
+
+
+def test_negative_literals():
+    assert (c.naive(-2) ** c.this).execute(2) == 4
+    assert (c.naive(-2.5) ** c.this).execute(2) == 6.25
+    assert get_return_code(c.naive(b"ab")) == "b'ab'"
+    assert get_return_code(c.naive(0.1)) == "0.1"
+    assert c.naive(float("nan")).execute(None) != c.naive(1).execute(None)
+    assert c.naive(float("inf")).execute(None) == float("inf")
+    assert c.naive("{0} %s").execute(None) == "{0} %s"
+
+
+def test_if_pruning():
+    conversion = c.if_(c.naive(True), c.item("a"), c.item("b"))
+    assert get_return_code(conversion) == "data_['a']"
+    conversion = c.if_(c.naive(1) > 2, c.item("a"), c.item("b"))
+    assert get_return_code(conversion) == "data_['b']"
+    assert get_return_code(c.if_(c.naive(0), c.naive(1), c.this)) == "data_"
+
+    conversion = c.if_multiple(
+        (c.naive(False), c.item("a")),
+        (c.item("x") > 0, c.item("b")),
+        (c.naive(True), c.item("c")),
+        (c.item("x") < 0, c.item("d")),
+        else_=c.item("e"),
+    )
+    code = get_code_str(conversion.gen_converter())
+    assert "['a']" not in code and "['d']" not in code
+    assert "['e']" not in code
+    assert conversion.execute({"x": 1, "b": 1, "c": 2}) == 1
+    assert conversion.execute({"x": -1, "b": 1, "c": 2}) == 2
+
+    conversion = c.if_multiple(
+        (c.naive(None), c.item("a")),
+        (c.naive(True), c.item("b")),
+        else_=c.item("c"),
+    )
+    assert get_return_code(conversion) == "data_['b']"
+
+
+def test_pruned_ifs_in_comprehensions():
+    assert c.iter(c.if_(False, 1, 2)).as_type(list).execute([1, 2]) == [2, 2]
+    assert c.iter(
+        c.if_(c.naive(True), c.this.pipe(lambda x: x + 1), 2)
+    ).as_type(list).execute([1, 2]) == [2, 3]
+    assert c.iter(
+        (
+            c.if_(c.naive(1) > 2, c.this, c.this * 10),
+            c.if_multiple((False, 1), (True, c.this + 1), else_=3),
+        )
+    ).as_type(list).execute([1, 2]) == [(10, 2), (20, 3)]
+    assert c.group_by(c.item("a")).aggregate(
+        {
+            "a": c.if_(c.naive(True), c.item("a"), None),
+            "b": c.if_multiple(
+                (False, None), else_=c.ReduceFuncs.Sum(c.item("b"))
+            ),
+        }
+    ).execute([{"a": 1, "b": 2}, {"a": 1, "b": 3}]) == [{"a": 1, "b": 5}]
+
+
+def test_and_or_pruning():
+    assert get_return_code(c.and_(c.naive(True), c.item("a"))) == (
+        "(data_['a'])"
+    )
+    assert get_return_code(c.or_(c.naive(0), c.item("a"), c.item("b"))) == (
+        "(data_['a'] or data_['b'])"
+    )
+    assert get_return_code(c.or_(c.item("a"), c.naive(1), c.item("b"))) == (
+        "(data_['a'] or 1)"
+    )
+    assert get_return_code(c.and_(c.naive(1), c.naive(2))) == "2"
+    assert get_return_code(c.or_(c.naive(0), c.naive(""))) == "''"
+    assert c.and_(c.item("a"), c.naive(0), c.item("b")).execute({"a": 1}) == 0
+    # a single operand is not compared to anything
+    assert c.eq(c.naive(1)).execute(None) == 1
+    assert c.eq(c.naive(1), c.naive(1)).execute(None) is True
+
+
+def test_dispatcher_pruning():
+    conversion = c.this.dispatch(
+        c.naive("b"),
+        {"a": c.item("a"), "b": c.item("b")},
+        default=c.item("c"),
+    )
+    assert get_return_code(conversion) == "data_['b']"
+
+    conversion = c.this.dispatch(
+        c.naive("x"), {"a": c.item("a")}, default=c.item("c")
+    )
+    assert get_return_code(conversion) == "data_['c']"
+
+    conversion = c.this.dispatch(c.item("k"), {"a": c.item("a")})
+    assert conversion.execute({"k": "a", "a": 1}) == 1
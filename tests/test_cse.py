@@ -0,0 +1,231 @@
+import pytest
+
+from convtools import conversion as c
+from tests.utils import get_code_str
+
+
+ROWS = [
+    {"payload": {"ok": True, "user": {"id": 1, "name": "a"}}},
+    {"payload": {"ok": False, "user": {"id": 2, "name": "b"}}},
+    {"payload": {"ok": True, "user": {"id": 3, "name": "c"}}},
+]
+
+
+def gen_plain_converter(conversion):
+    with c.CodeGenerationOptionsCtx() as options:
+        options.common_subexpressions = False
+        return conversion.gen_converter()
+
+
+def test_cse_hoists_repeated_lookups():
+    conversion = c.iter(
+        {
+            "id": c.item("payload", "user", "id"),
+            "name": c.item("payload", "user", "name"),
+            "id2": c.item("payload", "user", "id"),
+        }
+    ).as_type(list)
+    converter = conversion.gen_converter()
+    code = get_code_str(converter)
+    assert code.count("['payload']['user']") == 1
+    assert code.count("['id']") == 1
+    assert " in (" in code
+
+    plain_converter = gen_plain_converter(conversion)
+    assert " in (" not in get_code_str(plain_converter)
+    assert converter(ROWS) == plain_converter(ROWS)
+    assert converter(ROWS)[0] == {"id": 1, "name": "a", "id2": 1}
+
+
+@pytest.mark.parametrize(
+    "conversion",
+    [
+        c.iter(
+            (c.item("payload", "user", "id"), c.item("payload", "user")),
+            where=c.item("payload", "ok"),
+        ).as_type(list),
+        c.iter(
+            c.item("payload", "user", "id"),
+            where=c.and_(
+                c.item("payload", "ok"), c.item("payload", "user", "id") > 1
+            ),
+        ).as_type(set),
+        c.iter(
+            c.item("payload", "user", "name"),
+            where=c.item("payload", "user", "id") != 2,
+        ).as_type(tuple),
+        c.iter(
+            (c.item("payload", "user", "id"), c.item("payload", "user"))
+        ),
+        c.dict_comp(
+            c.item("payload", "user", "id"),
+            c.item("payload", "user", "name"),
+            where=c.item("payload", "ok"),
+        ),
+        c.iter(
+            (
+                c.item("payload", "user", "id"),
+                c.item("payload", "user", "name", default=None),
+                c.item("payload", "user").call_method("get", "id"),
+                c.item("payload", "user", "id").as_type(str),
+            )
+        ).as_type(list),
+    ],
+)
+def test_cse_results(conversion):
+    converter = conversion.gen_converter()
+    assert " in (" in get_code_str(converter)
+    result = converter(ROWS)
+    if not isinstance(result, (list, set, tuple, dict)):
+        result = list(result)
+        assert result == list(gen_plain_converter(conversion)(ROWS))
+    else:
+        assert result == gen_plain_converter(conversion)(ROWS)
+
+
+def test_cse_condition_and_items_bindings():
+    converter = (
+        c.iter(
+            (c.item("payload", "user", "id"), c.item("payload", "user")),
+            where=c.item("payload", "ok"),
+        )
+        .as_type(list)
+        .gen_converter()
+    )
+    code = get_code_str(converter)
+    # payload is bound before the condition, user - after
+    condition_start = code.index(" if ")
+    assert code.index("['payload'],)") < condition_start
+    assert code.index("['user'],)") > condition_start
+    assert converter(ROWS) == [
+        (1, {"id": 1, "name": "a"}),
+        (3, {"id": 3, "name": "c"}),
+    ]
+
+
+def test_cse_keeps_guarded_lookups():
+    rows = [{"a": {"b": 1}}, {"a": None}, {"x": 1}]
+    conversion = c.iter(
+        c.and_(c.item("a"), c.item("a", "b"), c.item("a", "b") + 1)
+    ).as_type(list)
+    assert conversion.execute(rows[:2]) == [2, None]
+
+    conversion = c.iter(
+        c.if_(
+            c.item("a"),
+            (c.item("a", "b"), c.item("a", "b")),
+            None,
+        )
+    ).as_type(list)
+    converter = conversion.gen_converter()
+    # only "a" is hoisted, "b" is looked up in the conditional branch
+    assert get_code_str(converter).count(" in (") == 1
+    assert converter(rows[:2]) == [(1, 1), None]
+
+    conversion = c.iter(
+        c.if_(c.item("x", default=False), c.item("x"), c.item("x", default=0))
+    ).as_type(list)
+    assert conversion.execute(rows) == [0, 0, 1]
+
+
+def test_cse_is_conservative_around_calls():
+    def pop_b(value):
+        return value.pop("b")
+
+    conversion = c.iter(
+        (
+            c.item("a", "b"),
+            c.call_func(pop_b, c.item("a")),
+            c.item("a").call_method("get", "b"),
+            c.item("a", "c"),
+            c.item("a", "c"),
+        )
+    ).as_type(list)
+    converter = conversion.gen_converter()
+    assert " in (" not in get_code_str(converter)
+    assert converter([{"a": {"b": 1, "c": 2}}]) == [(1, 1, None, 2, 2)]
+
+    conversion = c.iter(
+        (c.item("a"), c.item("a").call_method("pop", "b"), c.item("a"))
+    ).as_type(list)
+    assert " in (" not in get_code_str(conversion)
+
+    conversion = c.iter(
+        (
+            c.item("a", "c"),
+            c.inline_expr("{0}.pop('b')").pass_args(c.item("a")),
+            c.item("a", "c"),
+        )
+    ).as_type(list)
+    assert " in (" not in get_code_str(conversion)
+
+    conversion = c.iter(
+        (
+            c.item("a", "c"),
+            c.item("a", "c"),
+            c.item("a").pipe(c.iter(c.call_func(pop_b, c.this))),
+        )
+    ).as_type(list)
+    assert " in (" not in get_code_str(conversion)
+
+
+def test_cse_nested_functions_and_comprehensions():
+    rows = [{"a": {"b": [{"c": 1}, {"c": 2}], "d": 3}}]
+    conversion = c.iter(
+        {
+            "sum": c.item("a", "b").iter(c.item("c")).pipe(sum),
+            "len": c.item("a", "b").pipe(len),
+            "d": c.item("a", "d"),
+            "nested": c.item("a", "b")
+            .iter((c.item("c"), c.item("c") + 1))
+            .as_type(list),
+            "optional": c.tuple(
+                c.optional(c.item("a", "d"), skip_if=c.item("a", "d") > 5),
+                c.item("a", "d"),
+            ),
+        }
+    ).as_type(list)
+    converter = conversion.gen_converter()
+    assert converter(rows) == gen_plain_converter(conversion)(rows)
+    assert converter(rows) == [
+        {
+            "sum": 3,
+            "len": 2,
+            "d": 3,
+            "nested": [(1, 2), (2, 3)],
+            "optional": (3, 3),
+        }
+    ]
+
+
+def test_cse_instrumented():
+    converter = (
+        c.iter(
+            (c.item("payload", "user", "id"), c.item("payload", "user")),
+            where=c.item("payload", "ok"),
+        )
+        .as_type(list)
+        .gen_converter(instrument=True)
+    )
+    assert len(converter(ROWS)) == 2
+    assert converter.counters.snapshot()["filter_0"] == {
+        "rows_in": 3,
+        "rows_out": 2,
+        "selectivity": 2 / 3,
+    }
+
+
+def test_cse_skips_attributes():
+    class Row:
+        reads = 0
+
+        @property
+        def value(self):
+            self.reads += 1
+            return self.reads
+
+    converter = c.iter(
+        (c.attr("value"), c.attr("value")), where=c.attr("value")
+    ).as_type(list).gen_converter()
+    assert " in (" not in get_code_str(converter)
+    assert converter([Row()]) == [(2, 3)]
@@ -0,0 +1,136 @@
+import importlib.util
+import sys
+from datetime import date
+
+import pytest
+
+from convtools import conversion as c
+from convtools._export import gen_import, gen_literal_code
+
+
+class Custom:
+    def __init__(self, value):
+        self.value = value
+
+
+def import_from_path(module_name, path):
+    spec = importlib.util.spec_from_file_location(module_name, path)
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    return module
+
+
+def test_literal_code():
+    for value in [
+        None,
+        True,
+        1,
+        1.5,
+        "a",
+        b"b",
+        1j,
+        (),
+        (1,),
+        (1, "a"),
+        [1, [2]],
+        {1, 2},
+        set(),
+        frozenset(),
+        frozenset({1}),
+        {"a": (1, 2), 3: None},
+    ]:
+        code = gen_literal_code(value)
+        assert eval(code) == value and type(eval(code)) is type(value)
+
+    assert gen_literal_code(float("nan")) is None
+    assert gen_literal_code([1, Custom(1)]) is None
+    assert gen_literal_code({Custom(1): 1}) is None
+    assert gen_literal_code(date(2020, 1, 1)) is None
+
+
+def test_import():
+    from itertools import chain
+
+    assert gen_import(chain) == ("itertools", "chain")
+    assert gen_import(chain.from_iterable) == (
+        "itertools",
+        "chain.from_iterable",
+    )
+    assert gen_import(sys) == ("sys", "")
+    assert gen_import(Custom) == ("tests.test_export", "Custom")
+    assert gen_import(lambda x: x) is None
+    assert gen_import(Custom(1)) is None
+
+
+def test_export_module(tmp_path):
+    custom = Custom(10)
+    conversions = {
+        "totals": c.group_by(c.item("a")).aggregate(
+            {
+                "a": c.item("a"),
+                "sum": c.ReduceFuncs.Sum(c.item("b")),
+                "median": c.ReduceFuncs.Median(c.item("b")),
+                "array": c.ReduceFuncs.Array(
+                    c.item("b"), where=c.item("b") > 1
+                ),
+            }
+        ),
+        "items": c.iter(
+            {
+                "x": c.item("x", default=None),
+                "date": c.naive(date(2020, 1, 1)),
+                "custom": c.naive(custom).attr("value"),
+                "list": c.naive([1, 2, 3]),
+                "key": c.naive(frozenset({1})),
+            }
+        )
+        .sort(key=c.item("x"))
+        .as_type(list),
+        "flat": c.this.flatten().as_type(list),
+        "same_flat": c.this.flatten().as_type(list),
+    }
+    path = str(tmp_path / "exported_converters.py")
+    exported = c.export_module(conversions, path)
+    with open(path, encoding="utf-8") as f:
+        assert f.read() == exported.source
+
+    assert "def " in exported.source
+    assert exported.source.count("from_iterable(data_)") == 1
+    assert set(exported.injections.values()) == {date(2020, 1, 1), custom}
+
+    with pytest.raises(ValueError, match="requires injections"):
+        import_from_path("exported_converters", path)
+
+    c.provide_injections("exported_converters", exported.injections)
+    module = import_from_path("exported_converters", path)
+    assert module.__all__ == ["totals", "items", "flat", "same_flat"]
+
+    data = [{"a": 1, "b": 1, "x": 2}, {"a": 1, "b": 2, "x": 1}]
+    for name, conversion in conversions.items():
+        assert getattr(module, name)(
+            [[1], [2]] if "flat" in name else data
+        ) == conversion.execute([[1], [2]] if "flat" in name else data)
+
+    with pytest.raises(ValueError):
+        c.export_module({"_private": c.this}, name="x")
+    with pytest.raises(ValueError):
+        c.export_module({"a": c.this})
+
+
+def test_export_module_without_injections(tmp_path):
+    path = str(tmp_path / "exported_simple.py")
+    exported = c.export_module(
+        {
+            "converter": c.item("a", default=-1)
+            .pipe(c.this * 2)
+            .pipe(c.input_arg("k") + c.this)
+        },
+        path,
+    )
+    assert exported.injections == {}
+    # only names used by the generated code are emitted
+    assert "import sys" not in exported.source
+    assert "get_injections" not in exported.source
+    module = import_from_path("exported_simple", path)
+    assert module.converter({"a": 1}, k=1) == 3
+    assert module.converter({}, k=0) == -2
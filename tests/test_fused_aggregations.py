@@ -0,0 +1,127 @@
+from convtools import conversion as c
+from tests.utils import get_code_str
+
+
+ROWS = [
+    {"name": name, "dept": dept, "salary": salary}
+    for name, dept, salary in [
+        ("a", "x", 10),
+        ("b", "y", 20),
+        ("c", "x", None),
+        ("d", "z", 5),
+        ("e", "y", 7),
+    ]
+]
+
+
+def gen_unfused_converter(conversion):
+    with c.CodeGenerationOptionsCtx() as options:
+        options.fuse_aggregations = False
+        return c(conversion).gen_converter()
+
+
+def test_fused_aggregations():
+    conversion = c.tuple(
+        c.aggregate(c.ReduceFuncs.Sum(c.item("salary"))),
+        c.aggregate(
+            {
+                "max": c.ReduceFuncs.Max(c.item("salary")),
+                "names": c.ReduceFuncs.Array(
+                    c.item("name"), where=c.item("dept") != "z"
+                ),
+            }
+        ),
+        c.group_by(c.item("dept")).aggregate(
+            (c.item("dept"), c.ReduceFuncs.Count())
+        ),
+    )
+    converter = conversion.gen_converter()
+    code = get_code_str(converter)
+    assert code.count("iter(data_)") == 1
+    assert "aggregate_fused" in code
+
+    expected = (
+        42,
+        {"max": 20, "names": ["a", "b", "c", "e"]},
+        [("x", 2), ("y", 2), ("z", 1)],
+    )
+    assert converter(ROWS) == expected
+    # the input is iterated once
+    assert converter(iter(ROWS)) == expected
+    assert converter([]) == (0, {"max": None, "names": None}, [])
+    assert gen_unfused_converter(conversion)(ROWS) == expected
+
+
+def test_fused_aggregations_in_dicts_and_lists():
+    conversion = {
+        "by_dept": c.group_by(c.item("dept")).aggregate(
+            {
+                "dept": c.item("dept"),
+                "total": c.ReduceFuncs.Sum(c.item("salary"))
+                * c.input_arg("rate"),
+            }
+        ),
+        "count": c.aggregate(c.ReduceFuncs.Count()),
+        "by_name": c.group_by(c.item("name"))
+        .aggregate(c.item("name"))
+        .pipe(sorted),
+    }
+    converter = c(conversion).gen_converter()
+    assert get_code_str(converter).count("iter(data_)") == 1
+    assert converter(ROWS, rate=2) == {
+        "by_dept": [
+            {"dept": "x", "total": 20},
+            {"dept": "y", "total": 54},
+            {"dept": "z", "total": 10},
+        ],
+        "count": 5,
+        "by_name": ["a", "b", "c", "d", "e"],
+    }
+    assert converter(ROWS, rate=2) == gen_unfused_converter(conversion)(
+        ROWS, rate=2
+    )
+
+    conversion = [
+        c.aggregate(c.ReduceFuncs.Min(c.item("salary"))),
+        c.this.pipe(len),
+        c.group_by(c.item("dept")).aggregate(c.item("dept")),
+    ]
+    converter = c(conversion).gen_converter()
+    assert "aggregate_fused" in get_code_str(converter)
+    assert converter(ROWS) == [5, 5, ["x", "y", "z"]]
+
+    converter = c.tuple(
+        c.aggregate(c.ReduceFuncs.First(c.item("dept"))),
+        c.aggregate(c.ReduceFuncs.Last(c.item("dept"))),
+    ).gen_converter()
+    assert converter(iter(ROWS)) == ("x", "y")
+
+
+def test_fused_aggregations_are_skipped():
+    conversion = c.tuple(
+        c.aggregate(c.ReduceFuncs.Sum(c.item("salary"))),
+        c.aggregate(c.ReduceFuncs.Count()),
+    )
+    # separate stages are counted
+    converter = conversion.gen_converter(instrument=True)
+    assert converter(ROWS) == (42, 5)
+    assert len(converter.counters.snapshot()) == 2
+
+    assert "aggregate_fused" not in get_code_str(
+        gen_unfused_converter(conversion)
+    )
+
+    # a single aggregation and optional items are left as is
+    for conversion, expected in [
+        (c.tuple(c.aggregate(c.ReduceFuncs.Count()), c.this.pipe(len)), (5, 5)),
+        (
+            c.tuple(
+                c.aggregate(c.ReduceFuncs.Count()),
+                c.optional(c.aggregate(c.ReduceFuncs.Sum(c.item("salary")))),
+            ),
+            (5, 42),
+        ),
+    ]:
+        converter = conversion.gen_converter()
+        assert "aggregate_fused" not in get_code_str(converter)
+        assert converter(ROWS) == expected
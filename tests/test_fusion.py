@@ -0,0 +1,110 @@
+import pytest
+
+from convtools import conversion as c
+from tests.utils import get_code_str
+
+
+ROWS = [{"a": i, "b": i % 3, "c": {"d": i % 2}} for i in range(-3, 10)]
+
+
+def gen_nested_converter(conversion):
+    with c.CodeGenerationOptionsCtx() as options:
+        options.fuse_pipelines = False
+        return conversion.gen_converter()
+
+
+def get_return_code(converter):
+    return get_code_str(converter).split("return ", 1)[1].split("\n", 1)[0]
+
+
+def test_fusion_single_comprehension():
+    conversion = (
+        c.iter(c.item("a"))
+        .filter(c.this > 0)
+        .iter(c.this + 1)
+        .filter(c.this % 2)
+        .as_type(list)
+    )
+    converter = conversion.gen_converter()
+    code = get_return_code(converter)
+    assert code.startswith("[") and code.count(" for ") == 3
+    assert "data_)" not in code
+
+    nested_converter = gen_nested_converter(conversion)
+    assert get_return_code(nested_converter).count("data_)") == 1
+    assert converter(ROWS) == nested_converter(ROWS) == [3, 5, 7, 9]
+
+
+@pytest.mark.parametrize(
+    "conversion",
+    [
+        c.iter(c.item("a")).filter(c.this > 0),
+        c.iter(c.item("a")).filter(c.this > 0).as_type(set),
+        c.iter(c.item("a")).filter(c.this > 0).as_type(tuple),
+        c.iter(c.item("a")).filter(c.this > 0).pipe(sum),
+        c.iter(c.item("c")).filter(c.item("d")).iter(c.item("d")),
+        c.iter(c.item("c"))
+        .pipe(c.filter(c.item("d")))
+        .pipe(c.iter(c.item("d") + c.item("d"), where=c.item("d") >= 0))
+        .pipe(c.list_comp(c.this * 2)),
+        c.iter({"x": c.item("a"), "y": c.item("c", "d")})
+        .filter(c.item("x") > c.input_arg("min_x"))
+        .iter((c.item("y"), c.item("x")), where=c.item("y")),
+        c.iter(c.item("a"))
+        .filter(c.this > 0)
+        .iter(c.this.pipe(lambda x: x * 10, label_input="x"))
+        .as_type(list),
+        c.iter(c.item("a"))
+        .filter(c.this > 0)
+        .iter(c.this.pipe(range).iter(c.this + 1).as_type(list))
+        .as_type(list),
+    ],
+)
+def test_fusion_results(conversion):
+    converter = conversion.gen_converter()
+    nested_converter = gen_nested_converter(conversion)
+    kwargs = {"min_x": 1} if "min_x" in get_code_str(converter) else {}
+    result = converter(ROWS, **kwargs)
+    expected = nested_converter(ROWS, **kwargs)
+    if isinstance(result, (list, set, tuple, int, float)):
+        assert result == expected
+    else:
+        assert list(result) == list(expected)
+
+
+def test_fusion_is_lazy():
+    consumed = []
+
+    def gen():
+        for i in range(5):
+            consumed.append(i)
+            yield {"a": i}
+
+    result = c.iter(c.item("a")).filter(c.this > 0).iter(c.this * 2).execute(
+        gen()
+    )
+    assert consumed == []
+    assert next(result) == 2
+    assert consumed == [0, 1]
+
+
+def test_fusion_is_skipped():
+    # instrumented converters count each stage
+    converter = (
+        c.iter(c.item("a"))
+        .filter(c.this > 0)
+        .as_type(list)
+        .gen_converter(instrument=True)
+    )
+    assert converter(ROWS) == list(range(1, 10))
+    assert set(converter.counters.snapshot()) == {"iter_0", "filter_1"}
+
+    # lists are materialized
+    conversion = c.iter(c.item("a")).as_type(list).pipe(c.filter(c.this > 0))
+    assert get_return_code(conversion.gen_converter()).count("data_]") == 1
+
+    # labels on pipes are kept
+    conversion = c.iter(c.item("a")).pipe(
+        c.filter(c.this > 0), label_output="out"
+    )
+    assert list(conversion.execute(ROWS)) == list(range(1, 10))
@@ -1,11 +1,26 @@
+import json
+import os
 import re
+import subprocess
+import sys
+import threading
+import time
+import traceback
 from datetime import date
 from types import GeneratorType
+from unittest.mock import patch
 
 import pytest
 
 from convtools import conversion as c
-from convtools._base import LazyEscapedString, Namespace
+from convtools._base import (
+    BaseConversion,
+    LazyEscapedString,
+    Namespace,
+    gen_structural_key,
+)
+from convtools._heuristics import Weights
+from convtools._utils import BytecodeCache
 
 from .utils import get_code_str
 
@@ -942,3 +957,553 @@ def test_group_by_none_counts():
     ).gen_converter()
     assert converter((1,) * 10) == {1: 10}
     assert converter((None,) * 10) is None
+
+
+def test_group_by_structural_key():
+    assert (
+        c.group_by(c.item("a"))
+        .aggregate(c.ReduceFuncs.Sum(c.item("b") + 1))
+        .structurally_equals(
+            c.group_by(c.item("a")).aggregate(
+                c.ReduceFuncs.Sum(c.item("b") + 1)
+            )
+        )
+    )
+    assert (
+        not c.group_by(c.item("a"))
+        .aggregate(c.ReduceFuncs.Sum(c.item("b") + 1))
+        .structurally_equals(
+            c.group_by(c.item("z")).aggregate(
+                c.ReduceFuncs.Sum(c.item("b") + 1)
+            )
+        )
+    )
+    assert not (c.item("b") + 1).structurally_equals(c.item("b") + True)
+    assert not (c.item("b") + 1).structurally_equals(c.item("b") + 1.0)
+    assert not c.naive(0.0).structurally_equals(c.naive(-0.0))
+
+    # mutable objects are compared by identity
+    lst = [1]
+    assert c.naive(lst).structurally_equals(c.naive(lst))
+    assert not c.naive(lst).structurally_equals(c.naive([1]))
+
+    f = lambda x: x  # noqa: E731
+    assert c.call_func(f, c.this).structurally_equals(
+        c.call_func(f, c.this)
+    )
+    assert not c.call_func(f, c.this).structurally_equals(
+        c.call_func(lambda x: x, c.this)
+    )
+    assert gen_structural_key({"a": [1, {2}]}) == gen_structural_key(
+        {"a": [1, {2}]}
+    )
+
+
+def test_group_by_converters_cache():
+    c.converters_cache.cache_clear()
+    data = [{"a": 1, "b": 2}, {"a": 1, "b": 3}, {"a": 2, "b": -1}]
+
+    f1 = (
+        c.group_by(c.item("a"))
+        .aggregate({"a": c.item("a"), "b": c.ReduceFuncs.Sum(c.item("b"))})
+        .gen_converter(cache=True)
+    )
+    f2 = (
+        c.group_by(c.item("a"))
+        .aggregate({"a": c.item("a"), "b": c.ReduceFuncs.Sum(c.item("b"))})
+        .gen_converter(cache=True)
+    )
+    assert f1 is f2
+    assert f1(data) == [{"a": 1, "b": 5}, {"a": 2, "b": -1}]
+    info = c.converters_cache.cache_info()
+    assert (info.hits, info.misses, info.currsize) == (1, 1, 1)
+
+    # params are part of the key
+    f3 = (
+        c.group_by(c.item("a"))
+        .aggregate({"a": c.item("a"), "b": c.ReduceFuncs.Sum(c.item("b"))})
+        .gen_converter(cache=True, method=True)
+    )
+    assert f3 is not f1 and f3(None, data) == f1(data)
+    f4 = (
+        c.group_by(c.item("a"))
+        .aggregate({"a": c.item("a"), "b": c.ReduceFuncs.Sum(c.item("b"))})
+        .gen_converter(cache=True, class_method=True)
+    )
+    assert isinstance(f4, classmethod)
+    assert (
+        c.group_by(c.item("a"))
+        .aggregate({"a": c.item("a"), "b": c.ReduceFuncs.Sum(c.item("b"))})
+        .gen_converter(cache=True, class_method=True)
+        .__func__
+        is f4.__func__
+    )
+
+    # not cached unless asked
+    assert (
+        c.group_by(c.item("a"))
+        .aggregate({"a": c.item("a"), "b": c.ReduceFuncs.Sum(c.item("b"))})
+        .gen_converter()
+        is not f1
+    )
+    with c.OptionsCtx() as options:
+        options.cache = True
+        assert (
+            c.group_by(c.item("a"))
+            .aggregate(
+                {"a": c.item("a"), "b": c.ReduceFuncs.Sum(c.item("b"))}
+            )
+            .gen_converter()
+            is f1
+        )
+        assert (
+            c.group_by(c.item("z", default=None))
+            .aggregate({"b": c.ReduceFuncs.Sum(c.item("b"))})
+            .gen_converter()
+            is not f1
+        )
+
+    # debug mode always compiles
+    assert (
+        c.group_by(c.item("a"))
+        .aggregate({"a": c.item("a"), "b": c.ReduceFuncs.Sum(c.item("b"))})
+        .gen_converter(cache=True, debug=True)
+        is not f1
+    )
+
+    # unhashable naive values don't break lookups
+    assert c.naive([1, 2]).len().execute(None) == 2
+    converter = c.naive({"a": [1]}).item("a", 0).gen_converter(cache=True)
+    assert converter(None) == 1
+    c.converters_cache.cache_clear()
+
+
+def test_group_by_converters_cache_settings():
+    c.converters_cache.cache_clear()
+    conversion = c.group_by(c.item("a")).aggregate(
+        c.ReduceFuncs.Sum(c.item("b") + c.item("b"))
+    )
+    f1 = conversion.gen_converter(cache=True)
+    with c.CodeGenerationOptionsCtx() as options:
+        options.common_subexpressions = False
+        f2 = conversion.gen_converter(cache=True)
+        assert f2 is not f1
+        assert conversion.gen_converter(cache=True) is f2
+    assert conversion.gen_converter(cache=True) is f1
+
+    weight = Weights.ATTR_LOOKUP
+    Weights.ATTR_LOOKUP = weight + 1
+    try:
+        assert conversion.gen_converter(cache=True) is not f1
+    finally:
+        Weights.ATTR_LOOKUP = weight
+    assert conversion.gen_converter(cache=True) is f1
+    c.converters_cache.cache_clear()
+
+
+def test_group_by_converters_cache_eviction():
+    c.converters_cache.cache_clear()
+    maxsize = c.converters_cache.maxsize
+    c.converters_cache.resize(2)
+    try:
+        f1 = c.group_by(c.item(1)).aggregate(c.item(1)).gen_converter(
+            cache=True
+        )
+        c.group_by(c.item(2)).aggregate(c.item(2)).gen_converter(cache=True)
+        assert (
+            c.group_by(c.item(1)).aggregate(c.item(1)).gen_converter(
+                cache=True
+            )
+            is f1
+        )
+        c.group_by(c.item(3)).aggregate(c.item(3)).gen_converter(cache=True)
+        assert c.converters_cache.cache_info().currsize == 2
+        assert (
+            c.group_by(c.item(1)).aggregate(c.item(1)).gen_converter(
+                cache=True
+            )
+            is f1
+        )
+        assert c.converters_cache.cache_info().misses == 3
+        c.converters_cache.resize(0)
+        assert len(c.converters_cache) == 0
+        assert (
+            c.group_by(c.item(1)).aggregate(c.item(1)).gen_converter(
+                cache=True
+            )
+            is not f1
+        )
+        assert len(c.converters_cache) == 0
+    finally:
+        c.converters_cache.resize(maxsize)
+        c.converters_cache.cache_clear()
+
+
+def test_group_by_converters_cache_threads():
+    c.converters_cache.cache_clear()
+    results = []
+
+    def worker():
+        for _ in range(20):
+            results.append(
+                c.group_by(c.item("a"))
+                .aggregate(
+                    {"a": c.item("a"), "b": c.ReduceFuncs.Sum(c.item("b"))}
+                )
+                .gen_converter(cache=True)
+            )
+
+    threads = [threading.Thread(target=worker) for _ in range(4)]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    info = c.converters_cache.cache_info()
+    assert info.hits + info.misses == 80
+    assert info.currsize == 1
+    c.converters_cache.cache_clear()
+
+
+@pytest.mark.skipif(
+    not BytecodeCache.is_supported, reason="requires code.replace"
+)
+def test_group_by_bytecode_cache(tmp_path):
+    data = [{"a": 1, "b": 1}, {"a": 1, "b": 2}, {"a": 2, "b": 3}]
+    expected = [
+        {"a": 1, "b": 3, "c": [2], "d": 2},
+        {"a": 2, "b": 3, "c": [3], "d": 2},
+    ]
+    try:
+        c.bytecode_cache.enable(str(tmp_path))
+        c.bytecode_cache.clear()
+
+        assert (
+            c.group_by(c.item("a"))
+            .aggregate(
+                {
+                    "a": c.item("a"),
+                    "b": c.ReduceFuncs.Sum(c.item("b")),
+                    "c": c.ReduceFuncs.Array(
+                        c.item("b"), where=c.item("b") > 1
+                    ),
+                    "d": c.naive([1, 2]).len(),
+                }
+            )
+            .execute(data)
+            == expected
+        )
+        misses = c.bytecode_cache.misses
+        assert misses > 0 and c.bytecode_cache.hits == 0
+        assert len(os.listdir(tmp_path)) == misses
+
+        converter = (
+            c.group_by(c.item("a"))
+            .aggregate(
+                {
+                    "a": c.item("a"),
+                    "b": c.ReduceFuncs.Sum(c.item("b")),
+                    "c": c.ReduceFuncs.Array(
+                        c.item("b"), where=c.item("b") > 1
+                    ),
+                    "d": c.naive([1, 2]).len(),
+                }
+            )
+            .gen_converter()
+        )
+        assert converter(data) == expected
+        assert c.bytecode_cache.hits == misses
+        assert c.bytecode_cache.misses == misses
+
+        # filenames point to sources of the current process
+        storage = converter.__globals__["__convtools__code_storage"]
+        assert converter.__code__.co_filename in {
+            code_piece.abs_path
+            for code_piece in storage.key_to_code_piece.values()
+        }
+
+        # broken entries are recompiled
+        for name in os.listdir(tmp_path):
+            with open(os.path.join(tmp_path, name), "wb") as f:
+                f.write(b"garbage")
+        assert (
+            c.group_by(c.item("a"))
+            .aggregate(
+                {
+                    "a": c.item("a"),
+                    "b": c.ReduceFuncs.Sum(c.item("b")),
+                    "c": c.ReduceFuncs.Array(
+                        c.item("b"), where=c.item("b") > 1
+                    ),
+                    "d": c.naive([1, 2]).len(),
+                }
+            )
+            .execute(data)
+            == expected
+        )
+        assert c.bytecode_cache.misses == misses * 2
+
+        f = c.item("a").gen_converter()
+        f = c.item("a").gen_converter()
+        with pytest.raises(TypeError) as exc_info:
+            f(None)
+        assert any(
+            frame.filename == f.__code__.co_filename
+            for frame in traceback.extract_tb(exc_info.value.__traceback__)
+        )
+
+        c.bytecode_cache.clear()
+        assert os.listdir(tmp_path) == []
+    finally:
+        c.bytecode_cache.disable()
+
+    c.bytecode_cache.clear()
+    assert (
+        c.group_by(c.item("a"))
+        .aggregate({"a": c.item("a"), "b": c.ReduceFuncs.Sum(c.item("b"))})
+        .execute(data)
+        == [{"a": 1, "b": 3}, {"a": 2, "b": 3}]
+    )
+    assert c.bytecode_cache.hits == c.bytecode_cache.misses == 0
+
+
+@pytest.mark.skipif(
+    not BytecodeCache.is_supported, reason="requires code.replace"
+)
+def test_group_by_bytecode_cache_across_processes(tmp_path):
+    script = (
+        "from convtools import conversion as c\n"
+        "f = c.group_by(c.item('a')).aggregate(\n"
+        "    {'a': c.item('a'), 'b': c.ReduceFuncs.Sum(c.item('b'))}\n"
+        ").gen_converter()\n"
+        "assert f([{'a': 1, 'b': 2}]) == [{'a': 1, 'b': 2}]\n"
+        "print(c.bytecode_cache.hits, c.bytecode_cache.misses)\n"
+    )
+    env = dict(os.environ, PY_CONVTOOLS_BYTECODE_CACHE_DIR=str(tmp_path))
+    env["PYTHONPATH"] = os.pathsep.join(sys.path)
+    outputs = [
+        subprocess.check_output(
+            [sys.executable, "-c", script], env=env, text=True
+        ).split()
+        for _ in range(2)
+    ]
+    assert outputs[0][0] == "0" and outputs[0][1] != "0"
+    assert outputs[1] == [outputs[0][1], "0"]
+
+
+def test_group_by_lazy_converter():
+    data = [{"a": 2, "b": 1}, {"a": 1, "b": 2}, {"a": 2, "b": 3}]
+    gen_converter_in_ctx = BaseConversion.gen_converter_in_ctx
+    with patch.object(
+        BaseConversion,
+        "gen_converter_in_ctx",
+        autospec=True,
+        side_effect=gen_converter_in_ctx,
+    ) as mock:
+        converter = (
+            c.group_by(c.item("a"))
+            .aggregate(
+                {
+                    "a": c.item("a"),
+                    "b": c.ReduceFuncs.Sum(c.item("b") * c.input_arg("k")),
+                    "c": c.naive([1, 2]),
+                }
+            )
+            .pipe(c.sort(key=c.item("a")))
+            .gen_converter(lazy=True)
+        )
+        assert mock.call_count == 0
+        stub_code = converter.__code__
+
+        result = converter(data, k=2)
+        assert result == [
+            {"a": 1, "b": 4, "c": [1, 2]},
+            {"a": 2, "b": 8, "c": [1, 2]},
+        ]
+        assert mock.call_count == 1
+        assert converter.__code__ is not stub_code
+
+        assert converter(data, k=1)[0] == {"a": 1, "b": 2, "c": [1, 2]}
+        assert mock.call_count == 1
+
+    with c.OptionsCtx() as options:
+        options.lazy = True
+        converter = c.this + 1
+        converter = converter.gen_converter()
+        assert converter.__code__.co_filename == "<convtools lazy converter>"
+    assert converter(1) == 2
+    assert converter.__code__.co_filename != "<convtools lazy converter>"
+
+
+def test_group_by_lazy_methods():
+    class A:
+        k = 10
+        method = (
+            c.group_by()
+            .aggregate(
+                c.ReduceFuncs.Sum(c.this) + c.input_arg("self").attr("k")
+            )
+            .gen_converter(method=True, lazy=True)
+        )
+        class_method = (
+            c.group_by()
+            .aggregate(
+                c.ReduceFuncs.Sum(c.this) * c.input_arg("cls").attr("k")
+            )
+            .gen_converter(class_method=True, lazy=True)
+        )
+        custom = (
+            c.group_by()
+            .aggregate(c.ReduceFuncs.Sum(c.this) - c.input_arg("x"))
+            .gen_converter(signature="self, data_, x=1", lazy=True)
+        )
+
+    assert A().method([1]) == 11
+    assert A().method([1, 1]) == 12
+    assert A.class_method([2]) == 20
+    assert A().class_method([1, 2]) == 30
+    assert A().custom([5]) == 4
+    assert A().custom([2, 3], x=2) == 3
+
+
+def test_group_by_lazy_cached_converter():
+    converter = (
+        c.group_by(c.item("a"))
+        .aggregate(c.ReduceFuncs.Sum(c.item("b")))
+        .gen_converter(cache=True)
+    )
+    lazy_converter = (
+        c.group_by(c.item("a"))
+        .aggregate(c.ReduceFuncs.Sum(c.item("b")))
+        .gen_converter(lazy=True, cache=True)
+    )
+    assert lazy_converter([{"a": 1, "b": 2}, {"a": 1, "b": 3}]) == [5]
+    assert lazy_converter.__code__ is converter.__code__
+
+
+def test_group_by_lazy_converter_threads():
+    data = [{"a": 2, "b": 1}, {"a": 1, "b": 2}, {"a": 2, "b": 3}]
+    gen_converter_in_ctx = BaseConversion.gen_converter_in_ctx
+
+    def slow_gen_converter_in_ctx(*args, **kwargs):
+        time.sleep(0.05)
+        return gen_converter_in_ctx(*args, **kwargs)
+
+    with patch.object(
+        BaseConversion,
+        "gen_converter_in_ctx",
+        autospec=True,
+        side_effect=slow_gen_converter_in_ctx,
+    ) as mock:
+        converter = (
+            c.group_by(c.item("a"))
+            .aggregate(
+                {
+                    "a": c.item("a"),
+                    "b": c.ReduceFuncs.Sum(c.item("b") * c.input_arg("k")),
+                }
+            )
+            .pipe(c.sort(key=c.item("a")))
+            .gen_converter(lazy=True)
+        )
+        barrier = threading.Barrier(8)
+        results = []
+
+        def run():
+            barrier.wait()
+            results.append(converter(data, k=1))
+
+        threads = [threading.Thread(target=run) for _ in range(8)]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+
+        assert mock.call_count == 1
+    assert results == [[{"a": 1, "b": 2}, {"a": 2, "b": 4}]] * 8
+
+
+def test_group_by_codegen_profiler():
+    with c.CodegenProfiler() as profiler:
+        converter = (
+            c.group_by(c.item("a"))
+            .aggregate(
+                {
+                    "a": c.item("a"),
+                    "sum": c.ReduceFuncs.Sum(c.item("b")),
+                    "max": c.ReduceFuncs.Max(c.item("b")),
+                }
+            )
+            .pipe(c.sort(key=c.item("a")))
+            .gen_converter()
+        )
+        c.gen_converters({"x": c.item("x"), "y": c.item("y")})
+        c.item("x").gen_converter(cache=True)
+    assert converter([{"a": 1, "b": 2}]) == [{"a": 1, "sum": 2, "max": 2}]
+
+    report = profiler.report()
+    assert json.loads(json.dumps(report)) == report
+    assert set(report) == {"total_time", "phases", "conversions"}
+    assert {
+        "gen_converter",
+        "gen_converters",
+        "cache_lookup",
+        "gen_code",
+        "gen_random_name",
+        "replace_word",
+        "compile",
+        "exec",
+    }.issubset(report["phases"])
+    assert report["phases"]["gen_converter"]["calls"] == 2
+    assert report["phases"]["gen_converters"]["calls"] == 1
+    assert report["phases"]["compile"]["calls"] >= 3
+    assert {"Grouper", "GetItem", "SumReducer", "MaxReducer"}.issubset(
+        report["conversions"]
+    )
+    assert report["conversions"]["Grouper"]["calls"] == 1
+
+    phases = report["phases"]
+    assert abs(
+        sum(stats["self_time"] for stats in phases.values())
+        - report["total_time"]
+    ) < 1e-9
+    for stats in [*phases.values(), *report["conversions"].values()]:
+        assert 0 <= stats["self_time"] <= stats["time"] + 1e-9
+    assert phases["gen_code"]["time"] <= report["total_time"]
+    assert (
+        phases["gen_converter"]["time"] + phases["gen_converters"]["time"]
+        <= report["total_time"] + 1e-9
+    )
+
+    text = profiler.format_report(limit=3)
+    assert text.startswith("total: ")
+    assert "gen_code" in text and "Grouper" in text
+
+    # inactive outside of the context
+    c.group_by(c.item("a")).aggregate(c.item("a")).gen_converter()
+    assert profiler.report() == report
+    assert c.CodegenProfiler.active_count == 0
+
+
+def test_group_by_codegen_profiler_nesting_and_threads():
+    other_thread_reports = []
+
+    def run():
+        c.group_by(c.item("a")).aggregate(c.item("a")).gen_converter()
+        with c.CodegenProfiler() as thread_profiler:
+            c.item("a").gen_converter()
+        other_thread_reports.append(thread_profiler.report())
+
+    with c.CodegenProfiler() as outer:
+        with c.CodegenProfiler() as inner:
+            c.item("a").gen_converter()
+        thread = threading.Thread(target=run)
+        thread.start()
+        thread.join()
+        c.group_by(c.item("a")).aggregate(c.item("a")).gen_converter()
+
+    assert "Grouper" not in inner.report()["conversions"]
+    assert outer.report()["phases"]["gen_converter"]["calls"] == 1
+    assert "Grouper" in outer.report()["conversions"]
+    assert "GetItem" in other_thread_reports[0]["conversions"]
+    assert "Grouper" not in other_thread_reports[0]["conversions"]
+    assert c.CodegenProfiler.active_count == 0
@@ -0,0 +1,84 @@
+import json
+import os
+import subprocess
+import sys
+
+import pytest
+
+from convtools import _heuristics
+from convtools._heuristics import (
+    WEIGHT_NAMES,
+    Weights,
+    calibrate_weights,
+    get_environment,
+    load_weights,
+    measure_weights,
+    save_weights,
+)
+
+
+def test_measure_weights():
+    weights = measure_weights(repeat=1, min_time=0.001)
+    assert set(weights) == set(WEIGHT_NAMES)
+    assert weights["STEP"] == 100
+    assert all(type(value) is int and value > 0 for value in weights.values())
+    assert weights["UNPREDICTABLE"] == 100 * max(
+        value for name, value in weights.items() if name != "UNPREDICTABLE"
+    )
+
+
+def test_save_n_load_weights(tmp_path):
+    path = str(tmp_path / "dir" / "weights.json")
+    assert load_weights(path) is None
+
+    weights = calibrate_weights(path, repeat=1, min_time=0.001)
+    assert load_weights(path) == weights
+
+    weights = {name: index + 1 for index, name in enumerate(WEIGHT_NAMES)}
+    save_weights(path, weights)
+    assert load_weights(path) == weights
+
+    with open(path, encoding="utf-8") as f:
+        data = json.load(f)
+    for bad_data in [
+        {**data, "environment": "other 1.0 arm64"},
+        {**data, "weights": {**weights, "STEP": 0}},
+        {**data, "weights": {"STEP": 100}},
+        [],
+    ]:
+        with open(path, "w", encoding="utf-8") as f:
+            json.dump(bad_data, f)
+        assert load_weights(path) is None
+
+    with open(path, "w", encoding="utf-8") as f:
+        f.write("{")
+    assert load_weights(path) is None
+
+    assert get_environment().startswith(sys.implementation.name)
+
+
+def test_calibrate_weights_requires_path(monkeypatch):
+    monkeypatch.delenv(_heuristics.WEIGHTS_FILE_ENV_VAR, raising=False)
+    with pytest.raises(ValueError):
+        calibrate_weights()
+
+
+def test_weights_are_loaded_on_import(tmp_path):
+    path = str(tmp_path / "weights.json")
+    weights = {name: Weights.STEP for name in WEIGHT_NAMES}
+    weights["DICT_LOOKUP"] = 12345
+    save_weights(path, weights)
+
+    env = dict(os.environ)
+    env[_heuristics.WEIGHTS_FILE_ENV_VAR] = path
+    env["PYTHONPATH"] = os.pathsep.join(sys.path)
+    output = subprocess.check_output(
+        [
+            sys.executable,
+            "-c",
+            "from convtools import _heuristics as h;"
+            "print(h.Weights.DICT_LOOKUP, h.calibrated_weights_path)",
+        ],
+        env=env,
+    )
+    assert output.decode().split() == ["12345", path]
@@ -0,0 +1,121 @@
+from convtools import conversion as c
+from convtools._utils import RowsCounter
+from tests.utils import get_code_str
+
+
+ORDERS = [
+    {"id": 1, "user_id": 1, "amount": 10},
+    {"id": 2, "user_id": 1, "amount": 0},
+    {"id": 3, "user_id": 2, "amount": 5},
+    {"id": 4, "user_id": 3, "amount": 7},
+]
+USERS = [{"id": 1, "name": "a"}, {"id": 2, "name": "b"}]
+
+
+def test_instrumented_pipeline():
+    conversion = (
+        c.iter({"user_id": c.item("user_id"), "amount": c.item("amount")})
+        .pipe(c.filter(c.item("amount") > 0))
+        .pipe(
+            c.group_by(c.item("user_id")).aggregate(
+                {
+                    "user_id": c.item("user_id"),
+                    "total": c.ReduceFuncs.Sum(c.item("amount")),
+                }
+            )
+        )
+    )
+    converter = conversion.gen_converter(instrument=True)
+    assert converter(ORDERS) == conversion.execute(ORDERS)
+    assert converter.counters.snapshot() == {
+        "iter_0": {"rows_in": 4, "rows_out": 4, "selectivity": 1.0},
+        "filter_1": {"rows_in": 4, "rows_out": 3, "selectivity": 0.75},
+        "group_by_2": {"rows_in": 3, "groups": 3, "selectivity": 1.0},
+    }
+
+    converter(ORDERS[:2])
+    assert converter.counters.snapshot()["filter_1"] == {
+        "rows_in": 6,
+        "rows_out": 4,
+        "selectivity": 4 / 6,
+    }
+    converter.counters.reset()
+    assert converter.counters.snapshot()["filter_1"] == {
+        "rows_in": 0,
+        "rows_out": 0,
+        "selectivity": None,
+    }
+    converter(ORDERS)
+    assert converter.counters.snapshot()["group_by_2"]["groups"] == 3
+
+    # no overhead when off
+    converter = conversion.gen_converter()
+    assert not hasattr(converter, "counters")
+    assert "count_iter" not in get_code_str(converter)
+
+
+def test_instrumented_comprehensions():
+    converter = (
+        c.zip(
+            c.item("a").iter(c.this + 1, where=c.this > 1).as_type(set),
+            c.item("b").iter(c.this).as_type(tuple),
+        )
+        .pipe(c.dict_comp(c.item(0), c.item(1), where=c.item(0) < 4))
+        .gen_converter(instrument=True)
+    )
+    assert converter({"a": [1, 2, 3], "b": [4, 5, 6]}) == {3: 4}
+    snapshot = converter.counters.snapshot()
+    assert [stats["rows_in"] for stats in snapshot.values()] == [3, 3, 2]
+    assert [stats["rows_out"] for stats in snapshot.values()] == [2, 3, 1]
+
+    converter = c.aggregate(c.ReduceFuncs.Sum(c.this)).gen_converter(
+        instrument=True
+    )
+    assert converter(range(5)) == 10
+    assert converter.counters.snapshot() == {"aggregate_0": {"rows_in": 5}}
+
+    converter = (
+        c.this.iter(c.this * 2)
+        .as_type(list)
+        .gen_converter(lazy=True, instrument=True)
+    )
+    assert converter([1, 2]) == [2, 4]
+    assert converter.counters.snapshot()["iter_0"]["rows_in"] == 2
+
+
+def test_instrumented_joins():
+    for condition, how in [
+        (c.LEFT.item("user_id") == c.RIGHT.item("id"), "inner"),
+        (c.LEFT.item("user_id") == c.RIGHT.item("id"), "left"),
+        (c.LEFT.item("user_id") < c.RIGHT.item("id"), "inner"),
+    ]:
+        conversion = c.join(c.item(0), c.item(1), condition, how=how).pipe(
+            list
+        )
+        converter = conversion.gen_converter(instrument=True)
+        result = converter((ORDERS, USERS))
+        assert result == conversion.execute((ORDERS, USERS))
+        assert converter.counters.snapshot() == {
+            "join_0": {
+                "left_rows": 4,
+                "right_rows": 2,
+                "rows_out": len(result),
+                "selectivity": len(result) / 4,
+            }
+        }
+
+
+def test_rows_counter():
+    counter = RowsCounter()
+    assert counter.value == 0
+    assert list(counter.count_iter("abc")) == ["a", "b", "c"]
+    # reads don't affect the value
+    assert counter.value == 3
+    assert counter.value == 3
+    next(counter.counter)
+    assert counter.value == 4
+    counter.reset()
+    assert counter.value == 0
+    counter.add(2)
+    assert list(counter.count_iter("ab")) == ["a", "b"]
+    assert counter.value == 4
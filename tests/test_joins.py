@@ -1,8 +1,12 @@
+from itertools import count, islice, product
+from random import Random
+
 import pytest
 
 from convtools import conversion as c
 from convtools._base import Eq
 from convtools._conversion import _JoinConditions
+from convtools.contrib.tables import Table
 
 
 def test_join_conditions():
@@ -626,3 +630,365 @@ def test_join_with_complex_pipe():
             {"a": 3},
         ]
     ) == [1, 1, 2, 3, 3]
+
+
+@pytest.mark.parametrize("how", ["inner", "left", "right", "outer"])
+def test_sorted_join(how):
+    random = Random(how)
+    conditions = [
+        c.LEFT.item(0) == c.RIGHT.item(0),
+        c.and_(
+            c.LEFT.item(0) == c.RIGHT.item(0),
+            c.LEFT.item(1) != "b",
+            c.RIGHT.item(1) != "y",
+        ),
+        c.and_(
+            c.LEFT.item(0) == c.RIGHT.item(0),
+            c.LEFT.item(1) == c.RIGHT.item(1),
+        ),
+        c.and_(
+            c.LEFT.item(0) == c.RIGHT.item(0),
+            c.LEFT.item(1) < c.RIGHT.item(1),
+        ),
+    ]
+    for condition in conditions:
+        converter = c.join(
+            c.item(0), c.item(1), condition, how=how, sorted=True
+        ).gen_converter()
+        hash_converter = c.join(
+            c.item(0), c.item(1), condition, how=how
+        ).gen_converter()
+        for _ in range(300):
+            left, right = (
+                sorted(
+                    (random.randint(0, 6), random.choice("abcxy"))
+                    for _ in range(random.randint(0, 8))
+                )
+                for _ in range(2)
+            )
+            result = list(converter((iter(left), iter(right))))
+            expected = list(hash_converter((left, right)))
+            if how == "outer":
+                # unmatched right items come where they are encountered
+                assert sorted(result, key=repr) == sorted(expected, key=repr)
+            else:
+                assert result == expected
+
+
+def test_sorted_join_streams_inputs():
+    converter = c.join(
+        c.item(0),
+        c.item(1),
+        c.LEFT == c.RIGHT,
+        how="outer",
+        sorted=True,
+    ).gen_converter()
+    # infinite inputs
+    assert list(islice(converter((count(0, 2), count(0, 3))), 7)) == [
+        (0, 0),
+        (2, None),
+        (None, 3),
+        (4, None),
+        (6, 6),
+        (8, None),
+        (None, 9),
+    ]
+
+
+def test_sorted_join_unsorted_inputs():
+    converter = c.join(
+        c.item(0), c.item(1), c.LEFT == c.RIGHT, sorted=True
+    ).gen_converter()
+    with pytest.raises(ValueError, match="left input is not sorted"):
+        list(converter(([1, 3, 2], [1, 2, 3])))
+    with pytest.raises(ValueError, match="right input is not sorted"):
+        list(converter(([1, 2, 3], [1, 3, 2])))
+
+    with pytest.raises(ValueError, match="equality"):
+        c.join(
+            c.item(0), c.item(1), c.LEFT < c.RIGHT, sorted=True
+        ).gen_converter()
+
+
+def test_sorted_table_join():
+    left = [(1, "a"), (2, "b"), (2, "c"), (4, "d")]
+    right = [(0, "z"), (2, "y"), (3, "x"), (4, "w")]
+    for how in ("inner", "left", "right", "outer"):
+        result = list(
+            Table.from_rows(iter(left), ["id", "left"])
+            .join(
+                Table.from_rows(iter(right), ["id", "right"]),
+                on=["id"],
+                how=how,
+                presorted=True,
+            )
+            .into_iter_rows(tuple)
+        )
+        expected = list(
+            Table.from_rows(left, ["id", "left"])
+            .join(
+                Table.from_rows(right, ["id", "right"]),
+                on=["id"],
+                how=how,
+            )
+            .into_iter_rows(tuple)
+        )
+        assert sorted(result, key=repr) == sorted(expected, key=repr)
+
+
+@pytest.mark.parametrize("how", ["inner", "left", "right", "outer"])
+@pytest.mark.parametrize("build", ["left", "auto"])
+def test_join_build_side(how, build):
+    random = Random(f"{how}{build}")
+    conditions = [
+        c.LEFT.item(0) == c.RIGHT.item(0),
+        c.and_(
+            c.LEFT.item(0) == c.RIGHT.item(0),
+            c.LEFT.item(1) != "b",
+            c.RIGHT.item(1) != "y",
+        ),
+        c.and_(
+            c.LEFT.item(0) == c.RIGHT.item(0),
+            c.LEFT.item(1) == c.RIGHT.item(1),
+        ),
+        c.and_(
+            c.LEFT.item(0) == c.RIGHT.item(0),
+            c.LEFT.item(1) < c.RIGHT.item(1),
+        ),
+    ]
+    for condition in conditions:
+        converter = c.join(
+            c.item(0), c.item(1), condition, how=how, build=build
+        ).gen_converter()
+        expected_converter = c.join(
+            c.item(0), c.item(1), condition, how=how
+        ).gen_converter()
+        for _ in range(300):
+            left, right = (
+                [
+                    (random.randint(0, 6), random.choice("abcxy"))
+                    for _ in range(random.randint(0, 8))
+                ]
+                for _ in range(2)
+            )
+            result = list(converter((left, iter(right))))
+            expected = list(expected_converter((left, right)))
+            assert sorted(result, key=repr) == sorted(expected, key=repr)
+            assert all(
+                pair_left is None or pair_left in left
+                for pair_left, _ in result
+            )
+
+
+def test_join_build_side_auto():
+    converter = c.join(
+        c.item(0), c.item(1), c.LEFT == c.RIGHT, build="auto"
+    ).gen_converter()
+    # right one is hashed: pairs follow the order of left items
+    assert list(converter(([2, 1, 5], [1, 2]))) == [(2, 2), (1, 1)]
+    assert list(converter((iter([2, 1]), [1, 2]))) == [(2, 2), (1, 1)]
+    # left one is hashed: pairs follow the order of right items
+    assert list(converter(([2, 1], [1, 1, 2]))) == [(1, 1), (1, 1), (2, 2)]
+    assert list(converter(([2, 1], iter([1, 2])))) == [(1, 1), (2, 2)]
+
+    converter = c.join(
+        c.item(0),
+        c.item(1),
+        c.LEFT == c.RIGHT,
+        how="left",
+        build="left",
+    ).gen_converter()
+    assert list(converter(([3, 2, 1, 4], iter([1, 2])))) == [
+        (1, 1),
+        (2, 2),
+        (3, None),
+        (4, None),
+    ]
+    converter = c.join(
+        c.item(0),
+        c.item(1),
+        c.LEFT == c.RIGHT,
+        how="right",
+        build="left",
+    ).gen_converter()
+    assert list(converter(([3, 2, 1, 4], iter([5, 1, 2])))) == [
+        (None, 5),
+        (1, 1),
+        (2, 2),
+    ]
+
+    # nested loop joins ignore it
+    assert list(
+        c.join(
+            c.item(0), c.item(1), c.LEFT < c.RIGHT, build="left"
+        ).execute(([1, 2], [2]))
+    ) == [(1, 2)]
+
+    with pytest.raises(ValueError, match="build"):
+        c.join(c.item(0), c.item(1), c.LEFT == c.RIGHT, build="smaller")
+
+
+@pytest.mark.parametrize(
+    "direction,tolerance,by",
+    list(
+        product(
+            ["backward", "forward", "nearest"], [None, 0, 3], [False, True]
+        )
+    ),
+)
+def test_asof_join(direction, tolerance, by):
+    def naive_asof_join(left, right, direction, tolerance, by):
+        pairs = []
+        for left_item in left:
+            candidates = [
+                right_item
+                for right_item in right
+                if not by or right_item[1] == left_item[1]
+            ]
+            backward = [r for r in candidates if r[0] <= left_item[0]]
+            forward = [r for r in candidates if r[0] >= left_item[0]]
+            match = None
+            if direction == "backward":
+                match = backward[-1] if backward else None
+            elif direction == "forward":
+                match = forward[0] if forward else None
+            elif backward and forward:
+                forward_distance = forward[0][0] - left_item[0]
+                backward_distance = left_item[0] - backward[-1][0]
+                match = (
+                    forward[0]
+                    if forward_distance < backward_distance
+                    or forward_distance == 0
+                    else backward[-1]
+                )
+            else:
+                match = (backward[-1:] or forward[:1] or [None])[0]
+            if (
+                match is not None
+                and tolerance is not None
+                and abs(match[0] - left_item[0]) > tolerance
+            ):
+                match = None
+            pairs.append((left_item, match))
+        return pairs
+
+    converter = c.asof_join(
+        c.item(0),
+        c.item(1),
+        on=c.item(0),
+        by=c.item(1) if by else None,
+        direction=direction,
+        tolerance=tolerance,
+    ).gen_converter()
+    random = Random(f"{direction}{tolerance}{by}")
+    for _ in range(300):
+        left, right = (
+            sorted(
+                (random.randint(0, 20), random.choice(letters), index)
+                for index in range(random.randint(0, 10))
+            )
+            for letters in ("ab", "abc")
+        )
+        assert list(converter((iter(left), iter(right)))) == naive_asof_join(
+            left, right, direction, tolerance, by
+        )
+
+
+def test_asof_join_left_right_keys():
+    events = [{"ts": 1, "sym": "A"}, {"ts": 5, "sym": "B"}]
+    prices = [
+        {"time": 0, "symbol": "B", "price": 10},
+        {"time": 1, "symbol": "A", "price": 20},
+        {"time": 4, "symbol": "A", "price": 21},
+    ]
+    assert list(
+        c.asof_join(
+            c.item("events"),
+            c.item("prices"),
+            on=(c.item("ts"), c.item("time")),
+            by=(c.item("sym"), c.item("symbol")),
+        ).execute({"events": events, "prices": prices})
+    ) == [(events[0], prices[1]), (events[1], prices[0])]
+
+
+def test_asof_join_streams_inputs():
+    converter = c.asof_join(
+        c.this, c.input_arg("right"), on=c.this
+    ).gen_converter()
+    assert list(islice(converter(count(0, 2), right=count(0, 3)), 5)) == [
+        (0, 0),
+        (2, 0),
+        (4, 3),
+        (6, 6),
+        (8, 6),
+    ]
+
+
+def test_asof_join_errors():
+    for direction in ("backward", "forward", "nearest"):
+        converter = c.asof_join(
+            c.item(0), c.item(1), on=c.this, direction=direction
+        ).gen_converter()
+        with pytest.raises(ValueError, match="left input is not sorted"):
+            list(converter(([1, 3, 2], [1, 2, 3])))
+        with pytest.raises(ValueError, match="right input is not sorted"):
+            list(converter(([1, 2, 3], [1, 3, 2])))
+
+    with pytest.raises(ValueError, match="direction"):
+        c.asof_join(c.item(0), c.item(1), on=c.this, direction="closest")
+    with pytest.raises(ValueError, match="tuple"):
+        c.asof_join(c.item(0), c.item(1), on=(c.item(0),))
+
+
+def test_table_asof_join():
+    trades = [(1, "A", 100), (2, "B", 200), (6, "A", 300), (9, "B", 400)]
+    quotes = [(0, "A", 9.5), (1, "B", 20.1), (5, "A", 9.7), (8, "A", 9.8)]
+    result = list(
+        Table.from_rows(trades, ["ts", "sym", "qty"])
+        .join(
+            Table.from_rows(quotes, ["ts", "sym", "price"]),
+            on="ts",
+            how="asof",
+            by="sym",
+            tolerance=4,
+        )
+        .into_iter_rows(tuple)
+    )
+    assert result == [
+        (1, "A", 100, 9.5),
+        (2, "B", 200, 20.1),
+        (6, "A", 300, 9.7),
+        (9, "B", 400, None),
+    ]
+
+    table = Table.from_rows(trades, ["ts", "sym", "qty"]).join(
+        Table.from_rows(quotes, ["ts", "sym", "price"]),
+        on="ts",
+        how="asof",
+        direction="forward",
+    )
+    assert table.columns == ["ts", "sym_LEFT", "qty", "sym_RIGHT", "price"]
+    result = list(table.into_iter_rows(tuple))
+    assert result == [
+        (1, "A", 100, "B", 20.1),
+        (2, "B", 200, "A", 9.7),
+        (6, "A", 300, "A", 9.8),
+        (9, "B", 400, None, None),
+    ]
+
+    with pytest.raises(ValueError, match="column name"):
+        Table.from_rows(trades, ["ts", "sym", "qty"]).join(
+            Table.from_rows(quotes, ["ts", "sym", "price"]),
+            on=["ts"],
+            how="asof",
+        )
+
+    # asof arguments are not ignored by other joins
+    for kwargs in ({"by": "sym"}, {"direction": "backward"}, {"tolerance": 1}):
+        with pytest.raises(ValueError, match="asof joins only"):
+            Table.from_rows(trades, ["ts", "sym", "qty"]).join(
+                Table.from_rows(quotes, ["ts", "sym", "price"]),
+                on=["ts"],
+                how="left",
+                **kwargs,
+            )
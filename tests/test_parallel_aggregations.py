@@ -0,0 +1,145 @@
+import gc
+import multiprocessing
+import threading
+
+import pytest
+
+from convtools import _aggregations
+from convtools import conversion as c
+from tests.utils import get_code_str
+
+
+R = c.ReduceFuncs
+ROWS = [
+    {"a": i % 5, "b": i if i % 7 else None, "s": str(i % 3)}
+    for i in range(1000)
+]
+REDUCERS = {
+    "sum": R.Sum(c.item("b")),
+    "first": R.First(c.item("b")),
+    "last": R.Last(c.item("b")),
+    "array": R.Array(c.item("b")),
+    "median": R.Median(c.item("b"), where=c.item("b")),
+    "dict_count": R.DictCount(c.item("s")),
+}
+
+
+@pytest.mark.parametrize("batch_size", [1, 99, 10000])
+@pytest.mark.parametrize(
+    "aggregate",
+    [
+        c.aggregate,
+        lambda reducer, **kwargs: c.group_by(c.item("a"))
+        .aggregate({"a": c.item("a"), **reducer}, **kwargs)
+        .sort(key=c.item("a")),
+    ],
+)
+def test_parallel_aggregations(aggregate, batch_size):
+    expected = aggregate(REDUCERS).execute(ROWS)
+    converter = aggregate(
+        REDUCERS, parallel=3, batch_size=batch_size
+    ).gen_converter()
+    assert "parallel_aggregation" in get_code_str(converter)
+    assert converter(ROWS) == expected
+    assert converter(tuple(ROWS)) == expected
+    assert converter(iter(ROWS)) == expected
+    assert converter(row for row in ROWS) == expected
+
+
+def test_parallel_edge_cases():
+    assert c.aggregate(R.Sum(c.item("b")), parallel=2).execute([]) == 0
+    assert (
+        c.group_by(c.item("a"))
+        .aggregate(c.item("a"), parallel=2)
+        .execute(iter([]))
+        == []
+    )
+
+    # parallel=1 is a regular aggregation
+    converter = c.aggregate(R.Sum(c.item("b")), parallel=1).gen_converter()
+    assert "parallel_aggregation" not in get_code_str(converter)
+
+    # parallel aggregations are not fused with others
+    converter = c(
+        {
+            "parallel": c.aggregate(R.Count(), parallel=2),
+            "count": c.aggregate(R.Count()),
+        }
+    ).gen_converter()
+    assert "aggregate_fused" not in get_code_str(converter)
+    assert converter(ROWS) == {"parallel": 1000, "count": 1000}
+
+
+def test_parallel_errors():
+    with pytest.raises(ValueError, match="mergeable"):
+        c.aggregate(
+            c.reduce(lambda a, b: a + b, c.item("a"), initial=0), parallel=2
+        ).gen_converter()
+    with pytest.raises(ValueError, match="input args"):
+        c.aggregate(
+            R.Sum(c.item("a") * c.input_arg("k")), parallel=2
+        ).gen_converter()
+    with pytest.raises(ValueError):
+        c.aggregate(R.Count(), parallel=0)
+    with pytest.raises(ValueError):
+        c.aggregate(R.Count(), parallel=2, batch_size=0)
+
+
+def test_parallel_without_fork(monkeypatch):
+    monkeypatch.setattr(
+        multiprocessing, "get_all_start_methods", lambda: ["spawn"]
+    )
+    converter = c.aggregate(
+        R.Sum(c.item("b")), parallel=2, batch_size=10
+    ).gen_converter()
+    with pytest.warns(RuntimeWarning, match="fork"):
+        assert converter(ROWS) == c.aggregate(R.Sum(c.item("b"))).execute(
+            ROWS
+        )
+
+
+@pytest.mark.filterwarnings("ignore::DeprecationWarning")
+def test_parallel_pool_is_reused(monkeypatch):
+    if "fork" not in multiprocessing.get_all_start_methods():
+        pytest.skip("fork is unavailable")
+
+    pools = []
+    get_context = multiprocessing.get_context
+
+    class Context:
+        @staticmethod
+        def Pool(workers):
+            pools.append(get_context("fork").Pool(workers))
+            return pools[-1]
+
+    monkeypatch.setattr(multiprocessing, "get_context", lambda _: Context)
+    key_to_partial_converter = (
+        _aggregations.ParallelAggregation.key_to_partial_converter
+    )
+    keys = set(key_to_partial_converter)
+    converter = c.aggregate(R.Sum(c.item("b")), parallel=2).gen_converter()
+    (key,) = set(key_to_partial_converter) - keys
+    inputs = [ROWS, [{"b": 1}] * 10, tuple(ROWS[:10])] * 3
+    results = [None] * len(inputs)
+
+    def run(index):
+        results[index] = converter(inputs[index])
+
+    threads = [
+        threading.Thread(target=run, args=(index,))
+        for index in range(len(inputs))
+    ]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    assert results == [
+        c.aggregate(R.Sum(c.item("b"))).execute(data) for data in inputs
+    ]
+    assert len(pools) == 1
+
+    # workers are terminated once the converter is collected
+    del converter
+    gc.collect()
+    assert key not in key_to_partial_converter
+    assert pools[0]._state != "RUN"
@@ -0,0 +1,176 @@
+import pickle
+from operator import add
+
+import pytest
+
+from convtools import conversion as c
+from convtools._utils import _none
+from tests.utils import get_code_str
+
+
+ROWS = [
+    {"a": i % 3, "b": i if i % 5 else None, "s": str(i % 4)}
+    for i in range(1, 23)
+]
+R = c.ReduceFuncs
+B_NOT_NONE = c.item("b") + 0
+
+REDUCERS = {
+    "sum": R.Sum(c.item("b")),
+    "sum_or_none": R.SumOrNone(c.item("b")),
+    "sum_or_none_not_none": R.SumOrNone(B_NOT_NONE, where=c.item("b")),
+    "max": R.Max(c.item("b")),
+    "min": R.Min(c.item("b")),
+    "max_row": R.MaxRow(c.item("b")),
+    "min_row": R.MinRow(c.item("b")),
+    "count": R.Count(),
+    "count_b": R.Count(c.item("b")),
+    "count_distinct": R.CountDistinct(c.item("s")),
+    "first": R.First(c.item("b")),
+    "last": R.Last(c.item("b")),
+    "average": R.Average(c.item("b")),
+    "weighted_average": R.Average(c.item("a"), c.item("a") + 1),
+    "median": R.Median(B_NOT_NONE, where=c.item("b")),
+    "percentile": R.Percentile(
+        90, B_NOT_NONE, where=c.item("b"), interpolation="lower"
+    ),
+    "mode": R.Mode(c.item("s")),
+    "top": R.TopK(2, c.item("s")),
+    "array": R.Array(c.item("b")),
+    "array_distinct": R.ArrayDistinct(c.item("s")),
+    "array_sorted": R.ArraySorted(c.item("s"), reverse=True),
+    "dict": R.Dict(c.item("s"), c.item("b")),
+    "dict_array": R.DictArray(c.item("s"), c.item("b")),
+    "dict_array_distinct": R.DictArrayDistinct(c.item("s"), c.item("a")),
+    "dict_sum": R.DictSum(c.item("s"), c.item("b")),
+    "dict_sum_or_none": R.DictSumOrNone(c.item("s"), c.item("b")),
+    "dict_max": R.DictMax(c.item("s"), c.item("b")),
+    "dict_min": R.DictMin(c.item("s"), c.item("b")),
+    "dict_count": R.DictCount(c.item("s")),
+    "dict_count_b": R.DictCount(c.item("s"), c.item("b")),
+    "dict_count_distinct": R.DictCountDistinct(c.item("s"), c.item("a")),
+    "dict_first": R.DictFirst(c.item("s"), c.item("b")),
+    "dict_last": R.DictLast(c.item("s"), c.item("b")),
+    "filtered_out": R.Sum(c.item("b"), where=c.item("a") > 10),
+}
+
+
+def gen_partials(aggregation, rows, batch_size):
+    to_partial = aggregation.partial().gen_converter()
+    return [
+        # states are to be sent to other processes / stored on disk
+        pickle.loads(pickle.dumps(to_partial(rows[i : i + batch_size])))
+        for i in range(0, len(rows), batch_size)
+    ]
+
+
+@pytest.mark.parametrize("batch_size", [1, 5, 7, 100])
+@pytest.mark.parametrize(
+    "aggregation",
+    [
+        c.aggregate(REDUCERS),
+        c.group_by(c.item("a")).aggregate({"a": c.item("a"), **REDUCERS}),
+        c.group_by(c.item("a"), c.item("s")).aggregate(
+            (c.item("s"), c.item("a"), R.Sum(c.item("b")))
+        ),
+    ],
+)
+def test_merge_partials(aggregation, batch_size):
+    merge = aggregation.merge_partials().gen_converter()
+    expected = aggregation.execute(ROWS)
+    assert merge(gen_partials(aggregation, ROWS, batch_size)) == expected
+    assert merge(iter(gen_partials(aggregation, ROWS, batch_size))) == (
+        expected
+    )
+
+
+def test_partial_states():
+    aggregation = c.group_by(c.item("a")).aggregate(
+        {
+            "a": c.item("a"),
+            "sum": R.Sum(c.item("b")),
+            "sum2": R.Sum(c.item("b")),
+            "count": R.Count(where=c.item("a") > 0),
+        }
+    )
+    # the same reducers share a state, nothing reduced is _none
+    assert aggregation.partial().execute(ROWS[:4]) == {
+        1: (5, 2),
+        2: (2, 1),
+        0: (3, _none),
+    }
+    assert aggregation.partial().execute([]) == {}
+
+    # empty states survive pickling
+    aggregation = c.aggregate(R.Count())
+    states = aggregation.partial().execute([])
+    assert pickle.loads(pickle.dumps(states))[0] is states[0]
+    assert aggregation.merge_partials().execute([states, states]) == 0
+    assert aggregation.merge_partials().execute([]) == 0
+    assert aggregation.merge_partials().execute([states, (2,)]) == 2
+
+
+def test_partial_pipes():
+    aggregation = (
+        c.group_by(c.item("a"))
+        .aggregate((c.item("a"), R.Sum(c.item("b"))))
+        .sort()
+    )
+    assert aggregation.partial().pipe(len).execute(ROWS) == 3
+    assert aggregation.partial().iter(c.this).as_type(sorted).execute(
+        ROWS
+    ) == [0, 1, 2]
+    assert aggregation.merge_partials().iter(c.item(0)).as_type(
+        list
+    ).execute(gen_partials(aggregation, ROWS, 4)) == [0, 1, 2]
+
+    converter = c(
+        {
+            "partial": c.aggregate(R.Sum(c.item("b"))).partial(),
+            "total": c.aggregate(R.Sum(c.item("b"))),
+        }
+    ).gen_converter()
+    assert "aggregate_fused" not in get_code_str(converter)
+    assert converter(ROWS) == {"partial": (203,), "total": 203}
+
+
+def test_merge_custom_reduce():
+    aggregation = c.aggregate(
+        c.reduce(add, c.item("a"), initial=0, merge=add)
+    )
+    assert aggregation.merge_partials().execute(
+        gen_partials(aggregation, ROWS, 5)
+    ) == aggregation.execute(ROWS)
+
+    aggregation = c.aggregate(c.reduce(add, c.item("a"), initial=0))
+    with pytest.raises(ValueError, match="requires merge"):
+        aggregation.merge_partials().gen_converter()
+    # emitting partial states doesn't need merge
+    assert aggregation.partial().execute(ROWS) == (22,)
+
+
+def test_merge_custom_reduce_non_neutral_initial():
+    # max absorbs repetitions of initial
+    aggregation = c.aggregate(
+        c.reduce(max, c.item("a"), initial=1, merge=max)
+    )
+    assert aggregation.merge_partials().execute(
+        gen_partials(aggregation, ROWS, 5)
+    ) == aggregation.execute(ROWS)
+
+    # otherwise initial is accounted for once per partial state
+    aggregation = c.aggregate(
+        c.reduce(add, c.item("a"), initial=10, merge=add)
+    )
+    partials = gen_partials(aggregation, ROWS, 5)
+    assert len(partials) == 5
+    assert aggregation.merge_partials().execute(
+        partials
+    ) == aggregation.execute(ROWS) + 40
+
+
+def test_merge_initial():
+    aggregation = c.aggregate(R.Sum(c.item("a"), initial=10))
+    assert aggregation.partial().execute(ROWS) == (32,)
+    with pytest.raises(ValueError, match="initial"):
+        aggregation.merge_partials().gen_converter()
@@ -0,0 +1,115 @@
+from itertools import count, islice
+
+import pytest
+
+from convtools import conversion as c
+from tests.utils import get_code_str
+
+
+R = c.ReduceFuncs
+ROWS = [
+    {"a": i // 7, "b": i if i % 3 else None, "s": str(i % 4)}
+    for i in range(60)
+]
+REDUCER = {
+    "a": c.item("a"),
+    "sum": R.Sum(c.item("b")),
+    "first": R.First(c.item("b")),
+    "array": R.Array(c.item("b")),
+    "median": R.Median(c.item("b"), where=c.item("b")),
+    "dict_sum": R.DictSum(c.item("s"), c.item("b")),
+    "filtered_out": R.Sum(c.item("b"), where=c.item("a") > 100),
+}
+
+
+@pytest.mark.parametrize(
+    "by",
+    [
+        (c.item("a"),),
+        (c.item("a"), c.item("a") // 2),
+    ],
+)
+def test_presorted_group_by(by):
+    expected = c.group_by(*by).aggregate(REDUCER).execute(ROWS)
+    converter = (
+        c.group_by(*by, presorted=True).aggregate(REDUCER).gen_converter()
+    )
+    assert "signature_to_agg_data" not in get_code_str(converter)
+    result = converter(iter(ROWS))
+    assert not isinstance(result, list)
+    assert list(result) == expected
+
+    assert list(converter([])) == []
+    assert list(converter(ROWS[:1])) == (
+        c.group_by(*by).aggregate(REDUCER).execute(ROWS[:1])
+    )
+
+
+def test_presorted_group_by_is_lazy():
+    def gen_rows():
+        for i in count():
+            yield {"a": i // 3, "b": i}
+
+    aggregation = c.group_by(c.item("a"), presorted=True).aggregate(
+        (c.item("a"), R.Sum(c.item("b")))
+    )
+    assert list(islice(aggregation.execute(gen_rows()), 3)) == [
+        (0, 3),
+        (1, 12),
+        (2, 21),
+    ]
+    assert list(
+        islice(
+            aggregation.iter(c.item(1))
+            .filter(c.this > 20)
+            .execute(gen_rows()),
+            2,
+        )
+    ) == [21, 30]
+
+
+def test_presorted_group_by_pipes():
+    aggregation = c.group_by(c.item("a"), presorted=True).aggregate(
+        R.Sum(c.item("b"))
+    )
+    assert aggregation.as_type(list).execute(ROWS) == (
+        c.group_by(c.item("a")).aggregate(R.Sum(c.item("b"))).execute(ROWS)
+    )
+    assert aggregation.sort(reverse=True).execute(ROWS)[0] == max(
+        c.group_by(c.item("a")).aggregate(R.Sum(c.item("b"))).execute(ROWS)
+    )
+    assert aggregation.pipe(list).pipe(len).execute(ROWS) == 9
+
+    # like itertools.groupby, unordered keys form new groups
+    assert list(aggregation.execute([{"a": 1, "b": 1}] * 2 * 2)) == [4]
+    assert list(
+        aggregation.execute(
+            [{"a": 1, "b": 1}, {"a": 2, "b": 1}, {"a": 1, "b": 1}]
+        )
+    ) == [1, 1, 1]
+
+    # not fused with other aggregations
+    converter = c(
+        (aggregation.as_type(list), c.aggregate(R.Count()))
+    ).gen_converter()
+    assert "aggregate_fused" not in get_code_str(converter)
+    assert converter(ROWS)[1] == 60
+
+
+def test_presorted_group_by_errors():
+    with pytest.raises(ValueError, match="keys"):
+        c.group_by(presorted=True)
+    aggregation = c.group_by(c.item("a"), presorted=True).aggregate(
+        R.Count()
+    )
+    for method in ("partial", "merge_partials", "gen_aggregator"):
+        with pytest.raises(ValueError, match="presorted"):
+            getattr(aggregation, method)()
+    with pytest.raises(ValueError, match="presorted"):
+        c.group_by(c.item("a"), presorted=True).aggregate(
+            R.Count(), parallel=2
+        )
+    with pytest.raises(ValueError, match="presorted"):
+        c.group_by(c.item("a"), presorted=True).aggregate(
+            R.Count(), max_groups=2
+        )
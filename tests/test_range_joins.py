@@ -0,0 +1,203 @@
+from itertools import product
+from random import Random
+
+import pytest
+
+from convtools import conversion as c
+from convtools.contrib.tables import Table
+from tests.utils import get_code_str
+
+
+def naive_join(left, right, condition, how):
+    pairs = []
+    matched_right = set()
+    for left_item in left:
+        matched = False
+        for index, right_item in enumerate(right):
+            if condition(left_item, right_item):
+                matched = True
+                matched_right.add(index)
+                pairs.append((left_item, right_item))
+        if not matched and how in ("left", "outer"):
+            pairs.append((left_item, None))
+    if how in ("right", "outer"):
+        pairs.extend(
+            (None, right_item)
+            for index, right_item in enumerate(right)
+            if index not in matched_right
+        )
+    return pairs
+
+
+CONDITIONS = [
+    (
+        c.LEFT.item(0) < c.RIGHT.item(0),
+        lambda l, r: l[0] < r[0],
+    ),
+    (
+        c.RIGHT.item(0) <= c.LEFT.item(0),
+        lambda l, r: r[0] <= l[0],
+    ),
+    # band
+    (
+        c.and_(
+            c.LEFT.item(0) - 1 <= c.RIGHT.item(0),
+            c.RIGHT.item(0) < c.LEFT.item(0) + 2,
+        ),
+        lambda l, r: l[0] - 1 <= r[0] < l[0] + 2,
+    ),
+    # interval
+    (
+        c.and_(
+            c.LEFT.item(0) >= c.RIGHT.item(0),
+            c.LEFT.item(0) < c.RIGHT.item(1),
+            c.LEFT.item(1) != 0,
+        ),
+        lambda l, r: r[0] <= l[0] < r[1] and l[1] != 0,
+    ),
+    # interval overlap
+    (
+        c.and_(
+            c.LEFT.item(0) <= c.RIGHT.item(1),
+            c.RIGHT.item(0) <= c.LEFT.item(1),
+            c.RIGHT.item(1) > 2,
+        ),
+        lambda l, r: l[0] <= r[1] and r[0] <= l[1] and r[1] > 2,
+    ),
+]
+
+
+def gen_intervals(random):
+    return [
+        (start, start + random.randint(0, 4))
+        for start in (
+            random.randint(0, 9) for _ in range(random.randint(0, 8))
+        )
+    ]
+
+
+@pytest.mark.parametrize(
+    "how,condition_index,bisect",
+    list(
+        product(["inner", "left", "right", "outer"], range(5), [False, True])
+    ),
+)
+def test_range_join(how, condition_index, bisect):
+    condition, func = CONDITIONS[condition_index]
+    converter = c.join(
+        c.item(0), c.item(1), condition, how=how, bisect=bisect
+    ).gen_converter()
+    assert ("bisect" in get_code_str(converter)) is bisect
+
+    random = Random(f"{how}{condition_index}{bisect}")
+    for _ in range(300):
+        left = gen_intervals(random)
+        right = gen_intervals(random)
+        result = list(converter((left, iter(right))))
+        expected = naive_join(left, right, func, how)
+        assert sorted(result, key=repr) == sorted(expected, key=repr)
+        if not bisect and how != "right":
+            # nested loops
+            assert result == expected
+        elif how in ("inner", "left"):
+            # pairs follow left items
+            assert [pair[0] for pair in result] == [
+                pair[0] for pair in expected
+            ]
+
+
+def test_range_join_bisect_is_opt_in():
+    # comparisons of sets are not a total order
+    left = [{1}, {2}]
+    right = [{1, 2}, {3}, {1, 3}, {2, 5}]
+    assert list(
+        c.join(
+            c.item(0), c.item(1), c.LEFT.item("t") < c.RIGHT.item("t")
+        ).execute(
+            ([{"t": t} for t in left], [{"t": t} for t in right])
+        )
+    ) == [
+        ({"t": {1}}, {"t": {1, 2}}),
+        ({"t": {1}}, {"t": {1, 3}}),
+        ({"t": {2}}, {"t": {1, 2}}),
+        ({"t": {2}}, {"t": {2, 5}}),
+    ]
+
+    # the order of right elements is kept
+    converter = c.join(
+        c.item(0), c.item(1), c.LEFT < c.RIGHT, how="left"
+    ).gen_converter()
+    assert "bisect" not in get_code_str(converter)
+    assert list(converter(([1, 2], [3, 2, 5]))) == [
+        (1, 3),
+        (1, 2),
+        (1, 5),
+        (2, 3),
+        (2, 5),
+    ]
+    assert list(
+        c.join(
+            c.item(0), c.item(1), c.LEFT < c.RIGHT, how="left", bisect=True
+        ).execute(([1, 2], [3, 2, 5]))
+    ) == [(1, 2), (1, 3), (1, 5), (2, 3), (2, 5)]
+
+
+def test_range_join_keeps_short_circuiting():
+    left = [{"kind": "a", "ts": 1}]
+    right = [
+        {"kind": "a", "end": None},
+        {"kind": "a"},
+        {"kind": "b", "end": 2},
+    ]
+    converter = c.join(
+        c.item(0),
+        c.item(1),
+        c.and_(
+            c.LEFT.item("kind") != c.RIGHT.item("kind"),
+            c.LEFT.item("ts") < c.RIGHT.item("end"),
+        ),
+    ).gen_converter()
+    assert "bisect" not in get_code_str(converter)
+    assert list(converter((left, right))) == [(left[0], right[2])]
+
+
+def test_range_join_ignores_other_comparisons():
+    converter = c.join(
+        c.item(0),
+        c.item(1),
+        c.and_(c.LEFT < 5, c.LEFT + c.RIGHT < 5),
+        bisect=True,
+    ).gen_converter()
+    assert "bisect" not in get_code_str(converter)
+    assert list(converter(([1, 4, 7], {2, 3}))) == [(1, 2), (1, 3)]
+
+
+def test_table_range_join():
+    events = [(1, "a"), (5, "b"), (12, "c")]
+    sessions = [(0, 4, "x"), (4, 10, "y"), (3, 6, "z")]
+    result = list(
+        Table.from_rows(events, ["ts", "event"])
+        .join(
+            Table.from_rows(sessions, ["start", "end", "session"]),
+            on=c.and_(
+                c.LEFT.col("ts") >= c.RIGHT.col("start"),
+                c.LEFT.col("ts") < c.RIGHT.col("end"),
+            ),
+            how="left",
+        )
+        .into_iter_rows(tuple)
+    )
+    assert result == [
+        (1, "a", 0, 4, "x"),
+        (5, "b", 4, 10, "y"),
+        (5, "b", 3, 6, "z"),
+        (12, "c", None, None, None),
+    ]
+
+
+def test_nested_loop_right_join():
+    assert list(
+        c.join(
+            c.item(0), c.item(1), c.LEFT - c.RIGHT < 0, how="right"
+        ).execute(([1, 5], [3]))
+    ) == [(1, 3)]
@@ -0,0 +1,151 @@
+import cProfile
+import gc
+import io
+import json
+import pstats
+import sys
+
+import pytest
+
+from convtools import conversion as c
+
+
+@pytest.fixture
+def source_maps():
+    c.source_maps.clear()
+    c.source_maps.enable()
+    try:
+        yield c.source_maps
+    finally:
+        c.source_maps.disable()
+        c.source_maps.clear()
+
+
+def next_line():
+    return f"{__file__}:{sys._getframe(1).f_lineno + 1}"
+
+
+def get_code_location(converter):
+    code = converter.__code__
+    return code.co_filename, code.co_firstlineno
+
+
+def test_source_maps_disabled():
+    assert c.source_maps.enabled is False
+    conversion = c.item("a")
+    assert conversion._call_site is None
+    converter = conversion.gen_converter()
+    assert c.source_maps.lookup(*get_code_location(converter)) is None
+
+
+def test_source_maps_single(source_maps):
+    call_site = next_line()
+    conversion = c.iter(c.item("a") + 1).as_type(list)
+    assert conversion._call_site == call_site
+    assert conversion.structurally_equals(
+        c.iter(c.item("a") + 1).as_type(list)
+    )
+
+    converter = conversion.gen_converter()
+    assert converter([{"a": 1}]) == [2]
+
+    entry = source_maps.lookup(*get_code_location(converter))
+    assert entry.name == converter.__name__
+    assert entry.call_site == call_site
+    assert entry.description == f"ListComp @ {call_site}"
+    assert source_maps.get_conversion(
+        *get_code_location(converter)
+    ) is conversion
+    assert source_maps.lookup(entry.filename, entry.last_line + 1) is None
+    assert source_maps.lookup("unknown.py", 1) is None
+
+    del conversion
+    gc.collect()
+    assert source_maps.get_conversion(*get_code_location(converter)) is None
+
+
+def test_source_maps_batch(source_maps):
+    agg_call_site = next_line()
+    agg = c.group_by(c.item(0)).aggregate(
+        {"k": c.item(0), "s": c.ReduceFuncs.Sum(c.item(1))}
+    )
+    pipe_call_site = next_line()
+    pipe = c.item(0).pipe(c.this + 1)
+    converters = c.gen_converters({"agg": agg, "pipe": pipe})
+    assert converters["agg"]([(1, 2), (1, 3)]) == [{"k": 1, "s": 5}]
+    assert converters["pipe"]([1]) == 2
+
+    filename, _ = get_code_location(converters["agg"])
+    assert filename == get_code_location(converters["pipe"])[0]
+    assert (
+        source_maps.lookup(*get_code_location(converters["agg"])).call_site
+        == agg_call_site
+    )
+    assert (
+        source_maps.lookup(*get_code_location(converters["pipe"])).call_site
+        == pipe_call_site
+    )
+
+    code_storage = converters["agg"].__globals__["__convtools__code_storage"]
+    (code_piece,) = code_storage.batch_code_pieces
+    assert code_piece.abs_path == filename
+    lines = "".join(code_piece.code_parts).splitlines()
+    entries = source_maps.to_dict()[filename]
+    assert json.loads(json.dumps(entries)) == entries
+    for entry in entries:
+        assert entry["name"] in lines[entry["first_line"] - 1]
+        assert lines[entry["last_line"] - 1].strip()
+
+
+def test_annotate_stats(source_maps, tmp_path):
+    call_site = next_line()
+    conversion = c.group_by(c.item(0)).aggregate(c.ReduceFuncs.Sum(c.item(1)))
+    converter = conversion.gen_converter()
+
+    profile = cProfile.Profile()
+    profile.runcall(converter, [(1, 2), (2, 3)])
+    stream = io.StringIO()
+    stats = pstats.Stats(profile, stream=stream)
+    assert source_maps.annotate_stats(stats) is stats
+    stats.sort_stats("tottime").print_stats()
+    assert f"[Grouper @ {call_site}]" in stream.getvalue()
+
+    annotated = [
+        key for key in stats.stats if f"@ {call_site}]" in key[2]
+    ]
+    assert annotated
+    callers = {
+        caller
+        for _, _, _, _, key_callers in stats.stats.values()
+        for caller in key_callers
+    }
+    assert callers.intersection(annotated)
+
+    path = tmp_path / "source_maps.json"
+    source_maps.dump(str(path))
+    with open(path, encoding="utf-8") as f:
+        assert json.load(f) == source_maps.to_dict()
+
+
+def test_source_maps_eviction():
+    from convtools._source_maps import SourceMaps
+
+    source_maps = SourceMaps(max_entries=4)
+    conversion = c.this
+    source_maps.register("a.py", "\ndef b():\n    pass\n", conversion, 10)
+    source_maps.register("a.py", "def a():\n    pass\n", conversion)
+    assert source_maps.lookup("a.py", 2).name == "a"
+    assert source_maps.lookup("a.py", 12).name == "b"
+    assert source_maps.lookup("a.py", 14) is None
+
+    source_maps.register("b.py", "def c(): pass", conversion)
+    source_maps.register("a.py", "def d(): pass", conversion, 20)
+    # b.py is registered first now
+    source_maps.register("c.py", "def e(): pass", conversion)
+    assert source_maps.lookup("b.py", 1) is None
+    assert source_maps.lookup("a.py", 21).name == "d"
+    assert source_maps.lookup("c.py", 1).name == "e"
+
+    source_maps.register("d.py", "def f(): pass", conversion)
+    assert source_maps.lookup("a.py", 2) is None
+    assert list(source_maps.to_dict()) == ["c.py", "d.py"]
@@ -0,0 +1,139 @@
+import os
+import tempfile
+import tracemalloc
+
+import pytest
+
+from convtools import _aggregations
+from convtools import conversion as c
+
+
+R = c.ReduceFuncs
+ROWS = [
+    {"a": i % 500, "b": i if i % 7 else None, "s": str(i % 3)}
+    for i in range(5000)
+]
+REDUCER = {
+    "a": c.item("a"),
+    "sum": R.Sum(c.item("b")),
+    "count": R.Count(),
+    "first": R.First(c.item("b")),
+    "last": R.Last(c.item("b")),
+    "array": R.Array(c.item("b")),
+    "median": R.Median(c.item("b"), where=c.item("b")),
+    "count_distinct": R.CountDistinct(c.item("s")),
+    "dict_array": R.DictArray(c.item("s"), c.item("b")),
+    "dict_sum": R.DictSum(c.item("s"), c.item("b")),
+}
+
+
+def by_a(item):
+    return item["a"]
+
+
+@pytest.fixture
+def spill_dir(tmp_path, monkeypatch):
+    monkeypatch.setattr(tempfile, "tempdir", str(tmp_path))
+    return tmp_path
+
+
+@pytest.mark.parametrize(
+    "max_groups, spill_partitions", [(1, 1), (10, 4), (499, 16), (500, 16)]
+)
+def test_spill_to_disk(spill_dir, max_groups, spill_partitions):
+    spills = []
+
+    class GroupsSpiller(_aggregations.GroupsSpiller):
+        def spill(self, signature_to_states):
+            spills.append(len(signature_to_states))
+            super().spill(signature_to_states)
+
+    converter = (
+        c.group_by(c.item("a"))
+        .aggregate(
+            REDUCER, max_groups=max_groups, spill_partitions=spill_partitions
+        )
+        .gen_converter()
+    )
+    converter.__globals__["GroupsSpiller"] = GroupsSpiller
+    result = converter(iter(ROWS))
+
+    expected = c.group_by(c.item("a")).aggregate(REDUCER).execute(ROWS)
+    # groups come partition by partition
+    assert sorted(result, key=by_a) == expected
+    if max_groups < 500:
+        assert spills and max(spills) == max_groups + 1
+    else:
+        assert not spills
+    # temporary files are removed
+    assert not os.listdir(spill_dir)
+
+
+def test_spill_to_disk_pipes(spill_dir):
+    aggregation = c.group_by(c.item("s")).aggregate(
+        (c.item("s"), R.Sum(c.item("b"))), max_groups=1
+    )
+    assert aggregation.sort().execute(ROWS) == (
+        c.group_by(c.item("s"))
+        .aggregate((c.item("s"), R.Sum(c.item("b"))))
+        .sort()
+        .execute(ROWS)
+    )
+    assert aggregation.iter(c.item(1)).pipe(sum).execute(ROWS) == sum(
+        row["b"] or 0 for row in ROWS
+    )
+    assert aggregation.execute([]) == []
+    assert not os.listdir(spill_dir)
+
+    # spilling groupers aren't fused
+    assert c(
+        (aggregation.pipe(len), c.aggregate(R.Count()))
+    ).execute(ROWS) == (3, 5000)
+
+
+def test_spill_to_disk_bounds_memory(spill_dir):
+    def gen_rows():
+        for i in range(100000):
+            yield (i % 20000, i)
+
+    aggregation = c.group_by(c.item(0)).aggregate(
+        R.Array(c.item(1)).pipe(len)
+    )
+
+    def measure_peak(aggregation):
+        converter = aggregation.gen_converter()
+        tracemalloc.start()
+        try:
+            result = converter(gen_rows())
+            return tracemalloc.get_traced_memory()[1], result
+        finally:
+            tracemalloc.stop()
+
+    peak, result = measure_peak(aggregation)
+    spill_peak, spill_result = measure_peak(
+        c.group_by(c.item(0)).aggregate(
+            R.Array(c.item(1)).pipe(len), max_groups=1000
+        )
+    )
+    assert result == spill_result == [5] * 20000
+    assert spill_peak < peak / 2
+
+
+def test_spill_to_disk_errors():
+    with pytest.raises(ValueError, match="group_by only"):
+        c.aggregate(R.Count(), max_groups=10)
+    with pytest.raises(ValueError, match="parallel"):
+        c.group_by(c.item("a")).aggregate(
+            R.Count(), max_groups=10, parallel=2
+        )
+    with pytest.raises(ValueError):
+        c.group_by(c.item("a")).aggregate(R.Count(), max_groups=0)
+    with pytest.raises(ValueError):
+        c.group_by(c.item("a")).aggregate(
+            R.Count(), max_groups=10, spill_partitions=0
+        )
+    with pytest.raises(ValueError, match="merge"):
+        c.group_by(c.item("a")).aggregate(
+            c.reduce(lambda a, b: a + b, c.item("b"), initial=0),
+            max_groups=10,
+        ).gen_converter()
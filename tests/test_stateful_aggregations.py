@@ -0,0 +1,85 @@
+import pytest
+
+from convtools import conversion as c
+
+
+R = c.ReduceFuncs
+ROWS = [
+    {"a": i % 3, "b": i if i % 4 else None, "s": str(i % 5)}
+    for i in range(40)
+]
+REDUCERS = {
+    "sum": R.Sum(c.item("b")),
+    "max": R.Max(c.item("b")),
+    "first": R.First(c.item("b")),
+    "last": R.Last(c.item("b")),
+    "array": R.Array(c.item("b")),
+    "sorted": R.ArraySorted(c.item("s"), reverse=True),
+    "median": R.Median(c.item("b"), where=c.item("b")),
+    "count_distinct": R.CountDistinct(c.item("s")),
+    "dict_array": R.DictArray(c.item("s"), c.item("b")),
+    "dict_sum": R.DictSum(c.item("s"), c.item("b")),
+    "dict_sum_or_none": R.DictSumOrNone(c.item("s"), c.item("b")),
+    "dict": R.Dict(c.item("s"), c.item("b")),
+    "dict_max": R.DictMax(c.item("s"), c.item("b")),
+    "dict_count": R.DictCount(c.item("s"), c.item("b")),
+    "dict_first": R.DictFirst(c.item("s"), c.item("b")),
+    "dict_last": R.DictLast(c.item("s"), c.item("b")),
+    "top": R.TopK(2, c.item("s")),
+    "custom": c.reduce(
+        lambda a, b: a + b, c.item("a") * c.input_arg("k"), initial=0
+    ),
+}
+
+
+@pytest.mark.parametrize(
+    "aggregation",
+    [
+        c.aggregate(REDUCERS),
+        c.group_by(c.item("a")).aggregate({"a": c.item("a"), **REDUCERS}),
+        c.group_by(c.item("a"))
+        .aggregate({"a": c.item("a"), **REDUCERS})
+        .iter(c.item("sum"))
+        .as_type(sorted),
+    ],
+)
+def test_stateful_aggregations(aggregation):
+    aggregator = aggregation.gen_aggregator(k=2)
+    assert aggregator.snapshot() == aggregation.execute([], k=2)
+
+    snapshots = []
+    for i in range(0, len(ROWS), 7):
+        aggregator.update(iter(ROWS[i : i + 7]))
+        expected = aggregation.execute(ROWS[: i + 7], k=2)
+        assert aggregator.snapshot() == expected
+        # snapshots don't alter the state
+        snapshot = aggregator.snapshot()
+        assert snapshot == expected
+        snapshots.append((snapshot, expected))
+
+    aggregator.update([])
+    assert aggregator.snapshot() == aggregation.execute(ROWS, k=2)
+    # earlier snapshots don't change on further updates
+    for snapshot, expected in snapshots:
+        assert snapshot == expected
+
+    aggregator.reset()
+    assert aggregator.snapshot() == aggregation.execute([], k=2)
+    aggregator.update(ROWS[:3])
+    assert aggregator.snapshot() == aggregation.execute(ROWS[:3], k=2)
+
+
+def test_stateful_aggregators_are_independent():
+    aggregation = c.group_by(c.item("a")).aggregate(
+        (c.item("a"), R.Count())
+    )
+    aggregator1 = aggregation.gen_aggregator()
+    aggregator2 = aggregation.gen_aggregator()
+    aggregator1.update(ROWS)
+    aggregator2.update(ROWS[:1])
+    assert aggregator1.snapshot() == [(0, 14), (1, 13), (2, 13)]
+    assert aggregator2.snapshot() == [(0, 1)]
+
+    aggregator = c.aggregate(c.naive(1)).gen_aggregator()
+    aggregator.update(ROWS)
+    assert aggregator.snapshot() == 1